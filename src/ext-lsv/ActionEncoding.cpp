@@ -0,0 +1,181 @@
+#include "SokobanSolver.h"
+using namespace std;
+
+/*
+    Operator based encoding: besides the state literals, every step t -> t+1
+    has one variable per grounded action of a player,
+        move(p, c, d, t): player p walks from c to the neighbour in d,
+        push(p, c, d, t): player p at c pushes the box in d one square further.
+    Actions imply their preconditions and effects, and explanatory frame
+    axioms say that a player or box only changes position through an action.
+    The state literals are the same as in AllConstraints(), so the initial
+    and goal states and the solution decoder are shared.
+*/
+
+void SokobanSolver::ActionVariables()
+{
+    int nCells = board.numCells();
+    actionVars.assign(stepLimit * playerNum * nCells * 8, 0);
+    for (int t = 0; t < stepLimit; t++)
+    {
+        for (int player = 0; player < playerNum; player++)
+        {
+            for (int cell : board.walkableCells())
+            {
+                for (int dir = 0; dir < 4; dir++)
+                {
+                    int next = board.neighbour(cell, dir);
+                    if (next == -1 || !board.isWalkable(next))
+                        continue;
+                    int index = ((t * playerNum + player) * nCells + cell) * 8 + dir;
+                    actionVars[index] = layout.NewAuxVar();
+                    int beyond = board.beyond(cell, dir);
+                    // a box is never on a deadlock square, so it cannot be pushed from or onto one
+                    if (beyond == -1 || !board.isWalkable(beyond) || board.isDeadlock(next) || board.isDeadlock(beyond))
+                        continue;
+                    actionVars[index + 4] = layout.NewAuxVar();
+                }
+            }
+        }
+    }
+}
+
+void SokobanSolver::ActionPreconditionsAndEffects()
+{
+    for (int t = 0; t < stepLimit; t++)
+    {
+        for (int player = 0; player < playerNum; player++)
+        {
+            for (int cell : board.walkableCells())
+            {
+                for (int dir = 0; dir < 4; dir++)
+                {
+                    int next = board.neighbour(cell, dir);
+                    if (HasMove(cell, dir))
+                    {
+                        Lit move = MoveLit(cell, player, dir, t);
+                        AddClause({~move, PlayerLit(cell, player, t)});
+                        AddClause({~move, PlayerLit(next, player, t + 1)});
+                        if (!board.isDeadlock(next))
+                        {
+                            for (int box = 0; box < boxNum; box++)
+                                AddClause({~move, ~BoxLit(next, box, t)});
+                        }
+                    }
+                    if (HasPush(cell, dir))
+                    {
+                        Lit push = PushLit(cell, player, dir, t);
+                        int beyond = board.beyond(cell, dir);
+                        AddClause({~push, PlayerLit(cell, player, t)});
+                        AddClause({~push, PlayerLit(next, player, t + 1)});
+                        Clause &someBox = NewClause();
+                        someBox.AddLit(~push);
+                        for (int box = 0; box < boxNum; box++)
+                            someBox.AddLit(BoxLit(next, box, t));
+                        AddClause(someBox);
+                        for (int box = 0; box < boxNum; box++)
+                        {
+                            AddClause({~push, ~BoxLit(beyond, box, t)});
+                            AddClause({~push, ~BoxLit(next, box, t), BoxLit(beyond, box, t + 1)});
+                        }
+                    }
+                }
+            }
+        }
+    }
+}
+
+void SokobanSolver::ActionFrameAxioms()
+{
+    for (int t = 0; t < stepLimit; t++)
+    {
+        for (int player = 0; player < playerNum; player++)
+        {
+            for (int cell : board.walkableCells())
+            {
+                // P(c,t) & ~P(c,t+1) -> the player acted from c
+                Clause &leave = NewClause();
+                leave.AddLit(~PlayerLit(cell, player, t));
+                leave.AddLit(PlayerLit(cell, player, t + 1));
+                for (int dir = 0; dir < 4; dir++)
+                {
+                    if (HasMove(cell, dir))
+                        leave.AddLit(MoveLit(cell, player, dir, t));
+                    if (HasPush(cell, dir))
+                        leave.AddLit(PushLit(cell, player, dir, t));
+                }
+                AddClause(leave);
+                // ~P(c,t) & P(c,t+1) -> the player acted from a neighbour towards c
+                Clause &enter = NewClause();
+                enter.AddLit(PlayerLit(cell, player, t));
+                enter.AddLit(~PlayerLit(cell, player, t + 1));
+                for (int dir = 0; dir < 4; dir++)
+                {
+                    int from = board.neighbour(cell, Board::Opposite(dir));
+                    if (from == -1 || !board.isWalkable(from))
+                        continue;
+                    if (HasMove(from, dir))
+                        enter.AddLit(MoveLit(from, player, dir, t));
+                    if (HasPush(from, dir))
+                        enter.AddLit(PushLit(from, player, dir, t));
+                }
+                AddClause(enter);
+            }
+        }
+        for (int cell : board.walkableCells())
+        {
+            if (board.isDeadlock(cell))
+                continue;
+            // pushes that take a box off this cell, and pushes that put one on it
+            vector<Lit> off, on;
+            for (int dir = 0; dir < 4; dir++)
+            {
+                int pusher = board.neighbour(cell, Board::Opposite(dir));
+                if (pusher != -1 && board.isWalkable(pusher) && HasPush(pusher, dir))
+                {
+                    for (int player = 0; player < playerNum; player++)
+                        off.push_back(PushLit(pusher, player, dir, t));
+                }
+                pusher = board.beyond(cell, Board::Opposite(dir));
+                if (pusher != -1 && board.isWalkable(pusher) && HasPush(pusher, dir))
+                {
+                    for (int player = 0; player < playerNum; player++)
+                        on.push_back(PushLit(pusher, player, dir, t));
+                }
+            }
+            for (int box = 0; box < boxNum; box++)
+            {
+                Clause &leave = NewClause();
+                leave.AddLit(~BoxLit(cell, box, t));
+                leave.AddLit(BoxLit(cell, box, t + 1));
+                for (const Lit &push : off)
+                    leave.AddLit(push);
+                AddClause(leave);
+                Clause &enter = NewClause();
+                enter.AddLit(BoxLit(cell, box, t));
+                enter.AddLit(~BoxLit(cell, box, t + 1));
+                for (const Lit &push : on)
+                    enter.AddLit(push);
+                AddClause(enter);
+            }
+        }
+    }
+}
+
+void SokobanSolver::ActionConstraints()
+{
+    if (options.windows)
+        ComputeWindows(true);
+    ActionVariables();
+    InitState();
+    SolvedState();
+    ActionPreconditionsAndEffects();
+    ActionFrameAxioms();
+    // actions of one player exclude each other through the single placement of the player
+    PlayerSinglePlacementConstraints();
+    BoxSinglePlacementConstraints();
+    BoxCollisionConstraints();
+    BoxAndPlayerCollisionConstraints();
+    ExistenceConstraints();
+    tunnelMacro();
+}
@@ -0,0 +1,179 @@
+#include "AtMostOne.h"
+#include "SokobanSolver.h"
+#include <cmath>
+using namespace std;
+
+const char *AmoEncodingName(AmoEncoding encoding)
+{
+    switch (encoding)
+    {
+    case AmoEncoding::Auto:
+        return "auto";
+    case AmoEncoding::Pairwise:
+        return "pairwise";
+    case AmoEncoding::Sequential:
+        return "sequential";
+    case AmoEncoding::Commander:
+        return "commander";
+    case AmoEncoding::Product:
+        return "product";
+    case AmoEncoding::Bimander:
+        return "bimander";
+    }
+    return "unknown";
+}
+
+bool ParseAmoEncoding(const string &name, AmoEncoding &encoding)
+{
+    for (AmoEncoding e : {AmoEncoding::Auto, AmoEncoding::Pairwise, AmoEncoding::Sequential, AmoEncoding::Commander, AmoEncoding::Product, AmoEncoding::Bimander})
+    {
+        if (name == AmoEncodingName(e))
+        {
+            encoding = e;
+            return true;
+        }
+    }
+    return false;
+}
+
+AmoEncoding ChooseAmoEncoding(int domainSize)
+{
+    // pairwise is the strongest for propagation and still small for tiny domains;
+    // the counter wins up to a few dozen literals, the product encoding beyond
+    if (domainSize <= 6)
+        return AmoEncoding::Pairwise;
+    if (domainSize <= 40)
+        return AmoEncoding::Sequential;
+    return AmoEncoding::Product;
+}
+
+void SokobanSolver::AtMostOne(const vector<Lit> &input)
+{
+    // literals outside the distance windows are false and can be left out of the domain
+    vector<Lit> lits;
+    for (const Lit &lit : input)
+    {
+        if (!Pruned(lit))
+            lits.push_back(lit);
+    }
+    int nClausesBefore = nClauses;
+    int nVarsBefore = layout.numVars();
+    AmoEncoding encoding = options.amo == AmoEncoding::Auto ? ChooseAmoEncoding(lits.size()) : options.amo;
+    switch (encoding)
+    {
+    case AmoEncoding::Sequential:
+        AmoSequential(lits);
+        break;
+    case AmoEncoding::Commander:
+        AmoCommander(lits);
+        break;
+    case AmoEncoding::Product:
+        AmoProduct(lits);
+        break;
+    case AmoEncoding::Bimander:
+        AmoBimander(lits);
+        break;
+    default:
+        AmoPairwise(lits);
+        break;
+    }
+    stats.amoClauses += nClauses - nClausesBefore;
+    stats.amoVars += layout.numVars() - nVarsBefore;
+}
+
+void SokobanSolver::AmoPairwise(const vector<Lit> &lits)
+{
+    for (size_t i = 0; i < lits.size(); i++)
+    {
+        for (size_t j = i + 1; j < lits.size(); j++)
+            AddClause({~lits[i], ~lits[j]});
+    }
+}
+
+void SokobanSolver::AmoSequential(const vector<Lit> &lits)
+{
+    int n = lits.size();
+    if (n <= 2)
+        return AmoPairwise(lits);
+    // s[i] <=> one of lits[0..i] is true
+    vector<Lit> s(n - 1);
+    for (int i = 0; i < n - 1; i++)
+        s[i] = Lit(layout.NewAuxVar());
+    AddClause({~lits[0], s[0]});
+    for (int i = 1; i < n - 1; i++)
+    {
+        AddClause({~lits[i], s[i]});
+        AddClause({~s[i - 1], s[i]});
+        AddClause({~lits[i], ~s[i - 1]});
+    }
+    AddClause({~lits[n - 1], ~s[n - 2]});
+}
+
+void SokobanSolver::AmoCommander(const vector<Lit> &lits)
+{
+    const size_t groupSize = 3;
+    if (lits.size() <= groupSize + 1)
+        return AmoPairwise(lits);
+    vector<Lit> commanders;
+    for (size_t begin = 0; begin < lits.size(); begin += groupSize)
+    {
+        vector<Lit> group(lits.begin() + begin, lits.begin() + min(lits.size(), begin + groupSize));
+        Lit commander(layout.NewAuxVar());
+        AmoPairwise(group);
+        // commander <=> some literal of the group
+        Clause &some = NewClause();
+        some.AddLit(~commander);
+        for (const Lit &lit : group)
+            some.AddLit(lit);
+        AddClause(some);
+        for (const Lit &lit : group)
+            AddClause({~lit, commander});
+        commanders.push_back(commander);
+    }
+    AmoCommander(commanders);
+}
+
+void SokobanSolver::AmoProduct(const vector<Lit> &lits)
+{
+    int n = lits.size();
+    if (n <= 6)
+        return AmoPairwise(lits);
+    // place the literals on a p x q grid; a literal implies its row and its column
+    int p = ceil(sqrt((double)n));
+    int q = (n + p - 1) / p;
+    vector<Lit> rows(p), cols(q);
+    for (int i = 0; i < p; i++)
+        rows[i] = Lit(layout.NewAuxVar());
+    for (int j = 0; j < q; j++)
+        cols[j] = Lit(layout.NewAuxVar());
+    for (int k = 0; k < n; k++)
+    {
+        AddClause({~lits[k], rows[k / q]});
+        AddClause({~lits[k], cols[k % q]});
+    }
+    AmoProduct(rows);
+    AmoProduct(cols);
+}
+
+void SokobanSolver::AmoBimander(const vector<Lit> &lits)
+{
+    int n = lits.size();
+    if (n <= 6)
+        return AmoPairwise(lits);
+    // groups of two literals; the group index is spelled by binary commander bits
+    int nGroups = (n + 1) / 2;
+    int nBits = 0;
+    while ((1 << nBits) < nGroups)
+        nBits++;
+    vector<Lit> bits(nBits);
+    for (int b = 0; b < nBits; b++)
+        bits[b] = Lit(layout.NewAuxVar());
+    for (int k = 0; k < n; k++)
+    {
+        int group = k / 2;
+        if (k % 2 == 1)
+            AddClause({~lits[k - 1], ~lits[k]});
+        for (int b = 0; b < nBits; b++)
+            AddClause({~lits[k], (group >> b) & 1 ? bits[b] : ~bits[b]});
+    }
+}
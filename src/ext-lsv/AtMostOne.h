@@ -0,0 +1,27 @@
+#ifndef AT_MOST_ONE_H
+#define AT_MOST_ONE_H
+
+#include <string>
+
+using namespace std;
+
+/*
+    CNF encodings of "at most one of these literals is true".
+    Pairwise needs no auxiliary variables but n(n-1)/2 clauses; the others
+    trade auxiliary variables for a clause count that is (near) linear.
+*/
+enum class AmoEncoding
+{
+    Auto,       // pick by domain size, see ChooseAmoEncoding()
+    Pairwise,   // n(n-1)/2 binary clauses
+    Sequential, // Sinz' sequential counter: n-1 aux vars, 3n-4 clauses
+    Commander,  // Klieber-Kwon commander variables over groups of three
+    Product,    // Chen's 2-product over a sqrt(n) x sqrt(n) grid
+    Bimander    // Nguyen-Mai binary commanders over pairs
+};
+
+const char *AmoEncodingName(AmoEncoding encoding);
+bool ParseAmoEncoding(const string &name, AmoEncoding &encoding);
+AmoEncoding ChooseAmoEncoding(int domainSize);
+
+#endif // AT_MOST_ONE_H
@@ -0,0 +1,77 @@
+#include "Board.h"
+#include <algorithm>
+using namespace std;
+
+const int Board::dRow[4] = {-1, 1, 0, 0};
+const int Board::dCol[4] = {0, 0, -1, 1};
+
+int CellSet::count() const
+{
+    int n = 0;
+    for (uint64_t word : words)
+        n += __builtin_popcountll(word);
+    return n;
+}
+
+Board::Board(int rows, int cols) : nRows(rows), nCols(cols), types(rows * cols, 0) {}
+
+void Board::finalize()
+{
+    cellIndex.assign(nRows * nCols, -1);
+    cellCoords.clear();
+    for (int row = 0; row < nRows; row++)
+    {
+        for (int col = 0; col < nCols; col++)
+        {
+            if (types[row * nCols + col] & WALL)
+                continue;
+            cellIndex[row * nCols + col] = cellCoords.size();
+            cellCoords.push_back(make_pair(row, col));
+        }
+    }
+    int nCells = cellCoords.size();
+    walkable = CellSet(nCells);
+    targets = CellSet(nCells);
+    deadlocks = CellSet(nCells);
+    walkableList.clear();
+    targetList.clear();
+    neighbours.assign(nCells * 4, -1);
+    beyonds.assign(nCells * 4, -1);
+    for (int cell = 0; cell < nCells; cell++)
+    {
+        auto [row, col] = cellCoords[cell];
+        uint8_t type = cellType(cell);
+        if (type & WALKABLE)
+        {
+            walkable.set(cell);
+            walkableList.push_back(cell);
+        }
+        if (type & TARGET)
+        {
+            targets.set(cell);
+            targetList.push_back(cell);
+        }
+        if (type & DEADLOCK)
+            deadlocks.set(cell);
+        for (int dir = 0; dir < 4; dir++)
+        {
+            int next = cellId(row + dRow[dir], col + dCol[dir]);
+            neighbours[cell * 4 + dir] = next;
+            if (next != -1)
+                beyonds[cell * 4 + dir] = cellId(row + 2 * dRow[dir], col + 2 * dCol[dir]);
+        }
+    }
+}
+
+void Board::clearDeadlocks()
+{
+    for (uint8_t &type : types)
+        type &= ~DEADLOCK;
+    deadlocks.clear();
+}
+
+void Board::markDeadlock(int cell)
+{
+    types[cellCoords[cell].first * nCols + cellCoords[cell].second] |= DEADLOCK;
+    deadlocks.set(cell);
+}
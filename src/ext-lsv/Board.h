@@ -0,0 +1,110 @@
+#ifndef BOARD_H
+#define BOARD_H
+
+#include <vector>
+#include <utility>
+#include <cstdint>
+#include <algorithm>
+
+using namespace std;
+
+/*
+    Bit-packed set of cell ids.
+*/
+class CellSet
+{
+public:
+    CellSet() {}
+    explicit CellSet(int nCells) : words((nCells + 63) / 64, 0) {}
+    inline bool test(int cell) const { return (words[cell >> 6] >> (cell & 63)) & 1; }
+    inline void set(int cell) { words[cell >> 6] |= (uint64_t)1 << (cell & 63); }
+    inline void reset(int cell) { words[cell >> 6] &= ~((uint64_t)1 << (cell & 63)); }
+    inline void clear() { fill(words.begin(), words.end(), 0); }
+    int count() const;
+
+private:
+    vector<uint64_t> words;
+};
+
+/*
+    Static part of a level. Every non-wall square of the bounding box is a
+    cell with a linear id (row-major, so walkable cells come out in map order).
+    Attributes are kept both as one type byte per square, for coordinate
+    queries, and as one bit mask per attribute over cell ids. Neighbour
+    tables give the adjacent cell and the cell two squares away (the push
+    neighbour) in each direction, -1 when a wall is in the way.
+*/
+class Board
+{
+public:
+    enum Direction
+    {
+        UP = 0,
+        DOWN = 1,
+        LEFT = 2,
+        RIGHT = 3
+    };
+    enum CellType : uint8_t
+    {
+        WALL = 1,
+        WALKABLE = 2, // a floor square of the map file
+        TARGET = 4,
+        DEADLOCK = 8 // a box placed here can never reach a target
+    };
+    static const int dRow[4];
+    static const int dCol[4];
+    static inline int Opposite(int dir) { return dir ^ 1; }
+
+    Board() {}
+    Board(int rows, int cols);
+    void addType(int row, int col, uint8_t flags) { types[row * nCols + col] |= flags; }
+    void finalize(); // number the cells and build masks and neighbour tables
+    void clearDeadlocks();
+    void markDeadlock(int cell);
+
+    /*
+    ============ Squares ============
+    */
+    inline int rows() const { return nRows; }
+    inline int cols() const { return nCols; }
+    inline bool inside(int row, int col) const { return row >= 0 && row < nRows && col >= 0 && col < nCols; }
+    inline uint8_t type(int row, int col) const { return inside(row, col) ? types[row * nCols + col] : (uint8_t)WALL; }
+    inline bool isWall(int row, int col) const { return type(row, col) & WALL; }
+    inline bool isWalkable(int row, int col) const { return type(row, col) & WALKABLE; }
+    inline bool isTarget(int row, int col) const { return type(row, col) & TARGET; }
+    inline bool isDeadlock(int row, int col) const { return type(row, col) & DEADLOCK; }
+
+    /*
+    ============ Cells ============
+    */
+    inline int numCells() const { return cellCoords.size(); }
+    inline int cellId(int row, int col) const { return inside(row, col) ? cellIndex[row * nCols + col] : -1; }
+    inline const pair<int, int> &coord(int cell) const { return cellCoords[cell]; }
+    inline uint8_t cellType(int cell) const { return types[cellCoords[cell].first * nCols + cellCoords[cell].second]; }
+    inline bool isWalkable(int cell) const { return walkable.test(cell); }
+    inline bool isTarget(int cell) const { return targets.test(cell); }
+    inline bool isDeadlock(int cell) const { return deadlocks.test(cell); }
+    inline int neighbour(int cell, int dir) const { return neighbours[cell * 4 + dir]; }
+    inline int beyond(int cell, int dir) const { return beyonds[cell * 4 + dir]; }
+    inline const CellSet &walkableMask() const { return walkable; }
+    inline const CellSet &targetMask() const { return targets; }
+    inline const CellSet &deadlockMask() const { return deadlocks; }
+    inline const vector<int> &walkableCells() const { return walkableList; }
+    inline const vector<int> &targetCells() const { return targetList; }
+
+private:
+    int nRows = 0;
+    int nCols = 0;
+    vector<uint8_t> types;             // one byte per square
+    vector<int> cellIndex;             // square -> cell id, -1 for walls
+    vector<pair<int, int>> cellCoords; // cell id -> (row, col)
+    vector<int> neighbours;            // cell * 4 + dir -> adjacent cell
+    vector<int> beyonds;               // cell * 4 + dir -> cell two squares away
+    CellSet walkable;
+    CellSet targets;
+    CellSet deadlocks;
+    vector<int> walkableList;
+    vector<int> targetList;
+};
+
+#endif // BOARD_H
@@ -0,0 +1,47 @@
+#ifndef CLAUSE_ARENA_H
+#define CLAUSE_ARENA_H
+
+#include <vector>
+#include "ClauseSink.h"
+
+using namespace std;
+
+/*
+    Flat clause store. Literals of all clauses share one int buffer in ABC
+    literal encoding (2 * var + sign); clause i spans [offsets[i], offsets[i + 1]).
+    clear() keeps the capacity so one arena can be refilled horizon after
+    horizon, release() returns the memory.
+*/
+class ClauseArena : public ClauseSink
+{
+public:
+    ClauseArena() : offsets(1, 0) {}
+    inline void AddClause(const int *begin, const int *end) override
+    {
+        lits.insert(lits.end(), begin, end);
+        offsets.push_back(lits.size());
+    }
+    inline void clear()
+    {
+        lits.clear();
+        offsets.resize(1);
+    }
+    inline void release()
+    {
+        vector<int>().swap(lits);
+        vector<int>(1, 0).swap(offsets);
+    }
+
+    inline int numClauses() const { return offsets.size() - 1; }
+    inline int numLits() const { return lits.size(); }
+    inline int *begin(int i) { return lits.data() + offsets[i]; }
+    inline int *end(int i) { return lits.data() + offsets[i + 1]; }
+    inline const int *begin(int i) const { return lits.data() + offsets[i]; }
+    inline const int *end(int i) const { return lits.data() + offsets[i + 1]; }
+
+private:
+    vector<int> lits;    // literals of all clauses back to back
+    vector<int> offsets; // offsets[i] is the first literal of clause i
+};
+
+#endif // CLAUSE_ARENA_H
@@ -0,0 +1,170 @@
+#include "ClauseSharing.h"
+#include <thread>
+#include "sat/satoko/solver.h"
+using namespace std;
+
+/* ============ Shared clause buffer ============ */
+
+void SharedClauseBuffer::clear()
+{
+    for (size_t i = 0, end = min(used.load(), capacity); i < end; i++)
+        data[i].store(0, memory_order_relaxed);
+    used.store(0);
+}
+
+bool SharedClauseBuffer::Publish(int producer, const int *begin, const int *end)
+{
+    int size = end - begin;
+    size_t pos = used.fetch_add(2 + size);
+    if (pos + 2 + size > capacity)
+        return false;
+    data[pos].store(producer, memory_order_relaxed);
+    for (int k = 0; k < size; k++)
+        data[pos + 2 + k].store(begin[k], memory_order_relaxed);
+    data[pos + 1].store(size, memory_order_release);
+    return true;
+}
+
+void SharedClauseBuffer::Fetch(int consumer, size_t &pos, vector<int> &clauses) const
+{
+    while (pos + 2 <= capacity)
+    {
+        int size = data[pos + 1].load(memory_order_acquire);
+        if (size == 0) // not published yet
+            break;
+        if (data[pos].load(memory_order_relaxed) != consumer)
+        {
+            clauses.push_back(size);
+            for (int k = 0; k < size; k++)
+                clauses.push_back(data[pos + 2 + k].load(memory_order_relaxed));
+        }
+        pos += 2 + size;
+    }
+}
+
+void Satoko_ExportLearnts(satoko_t *pSat, int maxLbd, int maxSize, unordered_set<size_t> &exported, vector<int> &clauses)
+{
+    for (unsigned i = 0; i < vec_uint_size(pSat->learnts); i++)
+    {
+        struct clause *c = clause_fetch(pSat, vec_uint_at(pSat->learnts, i));
+        if ((int)c->lbd > maxLbd || (int)c->size > maxSize)
+            continue;
+        // the learnt list is compacted by clause database reductions, so
+        // clauses are recognised by their literals rather than their position
+        size_t hash = c->size;
+        for (unsigned k = 0; k < c->size; k++)
+            hash = hash * 1000003 + c->data[k].lit;
+        if (!exported.insert(hash).second)
+            continue;
+        clauses.push_back(c->size);
+        for (unsigned k = 0; k < c->size; k++)
+            clauses.push_back(c->data[k].lit);
+    }
+}
+
+/* ============ Clause-sharing backend ============ */
+
+// exchange after every slice of this many conflicts, glucose-syrup style limits
+static const int nSliceConflicts = 2000;
+static const int nShareMaxLbd = 3;
+static const int nShareMaxSize = 12;
+
+SharingBackend::SharingBackend(int nThreads) : buffer(1 << 20), nShared(0), nImported(0)
+{
+    if (nThreads <= 0)
+        nThreads = max(1, (int)thread::hardware_concurrency());
+    for (int i = 0; i < nThreads; i++)
+    {
+        members.emplace_back(NewSatBackend(SatBackendType::Satoko));
+        members.back()->Diversify(i);
+    }
+}
+
+void SharingBackend::SetNumVars(int nVars)
+{
+    for (auto &member : members)
+        member->SetNumVars(nVars);
+}
+
+void SharingBackend::SetRuntimeLimit(abctime nTimeToStop)
+{
+    for (auto &member : members)
+        member->SetRuntimeLimit(nTimeToStop);
+}
+
+SatStats SharingBackend::Stats() const
+{
+    SatStats stats = members[0]->Stats();
+    for (size_t i = 1; i < members.size(); i++)
+        stats.conflicts += members[i]->Stats().conflicts;
+    stats.shared = nShared;
+    stats.imported = nImported;
+    return stats;
+}
+
+bool SharingBackend::AddClauseImpl(const int *begin, const int *end)
+{
+    bool ok = true;
+    for (auto &member : members)
+    {
+        int nFailed = member->numFailed();
+        member->AddClause(begin, end);
+        ok &= member->numFailed() == nFailed;
+    }
+    return ok;
+}
+
+int SharingBackend::SolveImpl(const int *assumpBegin, const int *assumpEnd)
+{
+    // positions in the buffer refer to the clauses of this call only
+    buffer.clear();
+    int done = 0;
+    int status = l_Undef;
+    winner = 0;
+    atomic<int> finished(0);
+    auto run = [&](int id)
+    {
+        SatBackend &member = *members[id];
+        size_t pos = 0;
+        int nConflicts = 0;
+        vector<int> clauses;
+        member.SetStop(&done);
+        while (!done && !(pStop && *pStop) && (nConfLimit == 0 || nConflicts < nConfLimit))
+        {
+            int before = member.Stats().conflicts;
+            member.SetConflictBudget(nConfLimit ? min(nSliceConflicts, nConfLimit - nConflicts) : nSliceConflicts);
+            int result = member.Solve(assumpBegin, assumpEnd);
+            nConflicts += member.Stats().conflicts - before;
+            if (result != l_Undef)
+            {
+                if (finished.fetch_add(1) == 0)
+                {
+                    status = result;
+                    winner = id;
+                    done = 1;
+                }
+                break;
+            }
+            // the slice ran out: publish the new learnt clauses, take the others'
+            clauses.clear();
+            member.ExportLearnts(nShareMaxLbd, nShareMaxSize, clauses);
+            for (size_t i = 0; i < clauses.size(); i += 1 + clauses[i])
+                nShared += buffer.Publish(id, clauses.data() + i + 1, clauses.data() + i + 1 + clauses[i]);
+            clauses.clear();
+            buffer.Fetch(id, pos, clauses);
+            for (size_t i = 0; i < clauses.size(); i += 1 + clauses[i])
+            {
+                member.AddClause(clauses.data() + i + 1, clauses.data() + i + 1 + clauses[i]);
+                nImported++;
+            }
+        }
+        member.SetStop(nullptr);
+    };
+    vector<thread> threads;
+    for (size_t i = 1; i < members.size(); i++)
+        threads.emplace_back(run, i);
+    run(0);
+    for (thread &t : threads)
+        t.join();
+    return status;
+}
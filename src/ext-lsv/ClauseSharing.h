@@ -0,0 +1,73 @@
+#ifndef CLAUSE_SHARING_H
+#define CLAUSE_SHARING_H
+
+#include <atomic>
+#include <memory>
+#include <vector>
+#include <unordered_set>
+#include "SatBackend.h"
+#include "sat/satoko/satoko.h"
+
+using namespace std;
+
+/*
+    Append-only clause buffer shared by the solver threads, without locks.
+    A writer reserves room with one fetch_add and publishes the clause by
+    storing its size last; a reader stops at the first slot whose size is
+    still 0. Clauses that do not fit any more are dropped.
+    Layout of a clause: producer, size, literals.
+*/
+class SharedClauseBuffer
+{
+public:
+    explicit SharedClauseBuffer(size_t capacity) : data(new atomic<int>[capacity]()), capacity(capacity), used(0) {}
+    void clear(); // only while no thread reads or writes
+    bool Publish(int producer, const int *begin, const int *end);
+    // appends the clauses of other producers published after pos to clauses, each
+    // as its size followed by its literals, and moves pos past them
+    void Fetch(int consumer, size_t &pos, vector<int> &clauses) const;
+
+private:
+    unique_ptr<atomic<int>[]> data;
+    size_t capacity;
+    atomic<size_t> used;
+};
+
+/*
+    Several satoko instances solve the same CNF on their own threads with
+    diversified heuristics. They run in slices of a few thousand conflicts;
+    after every slice a member publishes its new short, low-LBD learnt
+    clauses and adds those of the others as ordinary clauses, which is sound
+    because learnt clauses follow from the CNF alone. The first member with
+    a definitive answer stops the others.
+*/
+class SharingBackend : public SatBackend
+{
+public:
+    explicit SharingBackend(int nThreads);
+    SatBackendType type() const override { return SatBackendType::Sharing; }
+    void SetNumVars(int nVars) override;
+    int VarValue(int var) const override { return members[winner]->VarValue(var); }
+    int FinalConflict(int **ppLits) override { return members[winner]->FinalConflict(ppLits); }
+    void SetStop(int *pStop) override { this->pStop = pStop; }
+    void SetRuntimeLimit(abctime nTimeToStop) override;
+    SatStats Stats() const override; // conflicts summed over the members
+
+protected:
+    bool AddClauseImpl(const int *begin, const int *end) override;
+    int SolveImpl(const int *assumpBegin, const int *assumpEnd) override;
+
+private:
+    vector<unique_ptr<SatBackend>> members;
+    SharedClauseBuffer buffer;
+    int winner = 0;        // member whose model or final conflict is reported
+    int *pStop = nullptr;
+    atomic<int> nShared;   // clauses published, over all Solve() calls
+    atomic<int> nImported; // clauses added to another member
+};
+
+// the learnt clause export of the satoko backend; it needs the solver internals,
+// whose struct clause clashes with the clause typedef of bsat
+void Satoko_ExportLearnts(satoko_t *pSat, int maxLbd, int maxSize, unordered_set<size_t> &exported, vector<int> &clauses);
+
+#endif // CLAUSE_SHARING_H
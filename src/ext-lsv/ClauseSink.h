@@ -0,0 +1,19 @@
+#ifndef CLAUSE_SINK_H
+#define CLAUSE_SINK_H
+
+#include <iostream>
+
+using namespace std;
+
+/*
+    Destination of the clauses produced by the constraint generators.
+    Literals are in ABC encoding (2 * var + sign).
+*/
+class ClauseSink
+{
+public:
+    virtual ~ClauseSink() {}
+    virtual void AddClause(const int *begin, const int *end) = 0;
+};
+
+#endif // CLAUSE_SINK_H
@@ -0,0 +1,106 @@
+#include "FrameCnf.h"
+#include "aig/gia/giaAig.h"
+#include "aig/saig/saig.h"
+#include "proof/cec/cec.h"
+using namespace std;
+
+FrameCnf::FrameCnf(Gia_Man_t *pGia, bool fOptimize)
+{
+    nAndsBefore = Gia_ManAndNum(pGia);
+    Gia_Man_t *pFrame = Gia_ManDup(pGia);
+    if (fOptimize)
+    {
+        // &dc2, then &fraig to merge the nodes that are equivalent for all register values
+        Gia_Man_t *pTemp = pFrame;
+        pFrame = Gia_ManCompress2(pTemp, 1, 0);
+        Gia_ManStop(pTemp);
+        Cec_ParFra_t Pars;
+        Cec_ManFraSetDefaultParams(&Pars);
+        pFrame = Cec_ManSatSweeping(pTemp = pFrame, &Pars, 1);
+        Gia_ManStop(pTemp);
+    }
+    nAndsAfter = Gia_ManAndNum(pFrame);
+    pAig = Gia_ManToAigSimple(pFrame);
+    Gia_ManStop(pFrame);
+    // derived as combinational logic, so that every output, the primary one
+    // included, gets a variable instead of being asserted
+    int nRegs = Aig_ManRegNum(pAig);
+    Aig_ManSetRegNum(pAig, 0);
+    pCnf = Cnf_Derive(pAig, Aig_ManCoNum(pAig));
+    Aig_ManSetRegNum(pAig, nRegs);
+    nFrameVars = pCnf->nVars;
+    nFrameClauses = pCnf->nClauses;
+}
+
+FrameCnf::~FrameCnf()
+{
+    Cnf_DataFree(pCnf);
+    Aig_ManStop(pAig);
+}
+
+void FrameCnf::Unroll(int nFrames, ClauseSink *pSink)
+{
+    Aig_Obj_t *pObj;
+    int i;
+    frameVars.clear();
+    nVars = nClauses = 0;
+    for (int frame = 0; frame < nFrames; frame++)
+    {
+        vector<int> vars(pCnf->nVars, -1);
+        if (frame > 0)
+        {
+            const vector<int> &previous = frameVars[frame - 1];
+            Saig_ManForEachLo(pAig, pObj, i)
+                vars[pCnf->pVarNums[pObj->Id]] = previous[pCnf->pVarNums[Saig_ObjLoToLi(pAig, pObj)->Id]];
+        }
+        for (int &var : vars)
+        {
+            if (var == -1)
+                var = nVars++;
+        }
+        for (int c = 0; c < pCnf->nClauses; c++)
+        {
+            lits.clear();
+            for (int *pLit = pCnf->pClauses[c]; pLit < pCnf->pClauses[c + 1]; pLit++)
+                lits.push_back(Abc_Var2Lit(vars[Abc_Lit2Var(*pLit)], Abc_LitIsCompl(*pLit)));
+            pSink->AddClause(lits.data(), lits.data() + lits.size());
+            nClauses++;
+        }
+        if (frame == 0)
+        {
+            Saig_ManForEachLo(pAig, pObj, i)
+            {
+                int lit = Abc_Var2Lit(vars[pCnf->pVarNums[pObj->Id]], 1);
+                pSink->AddClause(&lit, &lit + 1);
+                nClauses++;
+            }
+        }
+        frameVars.push_back(move(vars));
+    }
+}
+
+int FrameCnf::OutputLit(int frame, int po) const
+{
+    return Abc_Var2Lit(frameVars[frame][pCnf->pVarNums[Aig_ManCo(pAig, po)->Id]], 0);
+}
+
+int FrameCnf::InputVar(int frame, int pi) const
+{
+    return frameVars[frame][pCnf->pVarNums[Aig_ManCi(pAig, pi)->Id]];
+}
+
+Abc_Cex_t *FrameCnf::ModelToCex(const SatBackend &sat, int iFrame) const
+{
+    int nPis = Saig_ManPiNum(pAig);
+    Abc_Cex_t *pCex = Abc_CexAlloc(Saig_ManRegNum(pAig), nPis, iFrame + 1);
+    pCex->iFrame = iFrame;
+    for (int f = 0; f < iFrame; f++)
+    {
+        for (int pi = 0; pi < nPis; pi++)
+        {
+            if (sat.VarValue(InputVar(f, pi)))
+                Abc_InfoSetBit(pCex->pData, pCex->nRegs + f * nPis + pi);
+        }
+    }
+    return pCex;
+}
@@ -0,0 +1,53 @@
+#ifndef FRAME_CNF_H
+#define FRAME_CNF_H
+
+#include <vector>
+#include "aig/gia/gia.h"
+#include "sat/cnf/cnf.h"
+#include "SatBackend.h"
+
+using namespace std;
+
+/*
+    The CNF of one frame of a sequential AIG, derived once and instantiated
+    per frame. The frame logic is first optimised like "&dc2; &fraig" would
+    and then mapped into clauses by Cnf_Derive(). Frame t + 1 reuses the
+    variables of the register inputs of frame t as its register outputs, so
+    frames are chained without equality clauses. The registers of frame 0
+    are fixed to 0, the reset value of an AIG.
+*/
+class FrameCnf
+{
+public:
+    FrameCnf(Gia_Man_t *pGia, bool fOptimize); // pGia is copied
+    ~FrameCnf();
+    FrameCnf(const FrameCnf &) = delete;
+    FrameCnf &operator=(const FrameCnf &) = delete;
+
+    // adds frames 0 .. nFrames - 1 to pSink, variables from 0; the accessors below
+    // refer to the last unrolling
+    void Unroll(int nFrames, ClauseSink *pSink);
+    int numVars() const { return nVars; }
+    int numClauses() const { return nClauses; }
+    int OutputLit(int frame, int po = 0) const; // primary output po at frame, ABC literal
+    int InputVar(int frame, int pi) const;
+    // the inputs of frames 0 .. iFrame - 1 of the last model of sat, as a counter-example
+    // of the AIG failing at iFrame; the caller frees it
+    Abc_Cex_t *ModelToCex(const SatBackend &sat, int iFrame) const;
+
+    // size of the frame logic before and after the optimisation, and of its CNF
+    int nAndsBefore = 0;
+    int nAndsAfter = 0;
+    int nFrameVars = 0;
+    int nFrameClauses = 0;
+
+private:
+    Aig_Man_t *pAig = nullptr;
+    Cnf_Dat_t *pCnf = nullptr;
+    vector<vector<int>> frameVars; // frame -> variable of the frame CNF -> solver variable
+    vector<int> lits;              // scratch clause
+    int nVars = 0;
+    int nClauses = 0;
+};
+
+#endif // FRAME_CNF_H
@@ -0,0 +1,119 @@
+#include "SokobanSolver.h"
+#include <map>
+using namespace std;
+
+/*
+    Instances for k-induction on the property "the level is not solved".
+    The base case is plain BMC. The step case of length k starts anywhere
+    and is solved at frame k but at no earlier frame; when it is UNSAT, the
+    last k + 1 states of a shortest plan of k moves or more cannot exist, so
+    every plan is shorter than k. The forward case starts at the initial
+    state and is never solved; when it is UNSAT, every shortest plan has at
+    most k moves, which bounds the recurrence diameter of the unsolved part
+    of the state space. Both only hold for simple paths, whose states are
+    pairwise distinct, as shortest plans are. Distinctness is added lazily,
+    for the pairs of frames that a model shows to be equal.
+*/
+
+void SokobanSolver::FreeInitState()
+{
+    // a box that starts on a dead square makes the level unsolvable, so no reachable
+    // state has one there, and the placement constraints give at most one cell
+    for (int player = 0; player < playerNum; player++)
+    {
+        Clause &somewhere = NewClause();
+        for (int cell : board.walkableCells())
+            somewhere.AddLit(PlayerLit(cell, player, 0));
+        AddClause(somewhere);
+    }
+    for (int box = 0; box < boxNum; box++)
+    {
+        Clause &somewhere = NewClause();
+        for (int cell : board.walkableCells())
+        {
+            if (!board.isDeadlock(cell))
+                somewhere.AddLit(BoxLit(cell, box, 0));
+        }
+        AddClause(somewhere);
+    }
+}
+
+void SokobanSolver::UnsolvedStates(int lastFrame)
+{
+    // free(target, t) -> no box on the target at t; some target is free at every frame
+    vector<Lit> free;
+    for (int t = 0; t <= lastFrame; t++)
+    {
+        free.clear();
+        for (int target : board.targetCells())
+        {
+            Lit targetFree(layout.NewAuxVar());
+            for (int box = 0; box < boxNum; box++)
+                AddClause({~targetFree, ~BoxLit(target, box, t)});
+            free.push_back(targetFree);
+        }
+        Clause &some = NewClause();
+        for (const Lit &lit : free)
+            some.AddLit(lit);
+        AddClause(some);
+    }
+}
+
+vector<pair<int, int>> SokobanSolver::EqualStates(const SatBackend &sat) const
+{
+    // a state is the cell of every player and of every box, in order
+    map<vector<int>, int> firstFrame;
+    vector<pair<int, int>> equal;
+    vector<int> state;
+    for (int t = 0; t <= stepLimit; t++)
+    {
+        state.clear();
+        for (int player = 0; player < playerNum; player++)
+        {
+            for (int cell : board.walkableCells())
+            {
+                if (sat.VarValue(PlayerLit(cell, player, t).var()))
+                    state.push_back(cell);
+            }
+        }
+        for (int box = 0; box < boxNum; box++)
+        {
+            for (int cell : board.walkableCells())
+            {
+                if (!board.isDeadlock(cell) && sat.VarValue(BoxLit(cell, box, t).var()))
+                    state.push_back(cell);
+            }
+        }
+        auto [it, fresh] = firstFrame.emplace(state, t);
+        if (!fresh)
+            equal.push_back(make_pair(it->second, t));
+    }
+    return equal;
+}
+
+void SokobanSolver::DistinctStates(int i, int j)
+{
+    // differ(v) -> the state literal v has different values at frames i and j
+    vector<pair<Lit, Lit>> stateLits;
+    for (int cell : board.walkableCells())
+    {
+        for (int player = 0; player < playerNum; player++)
+            stateLits.push_back(make_pair(PlayerLit(cell, player, i), PlayerLit(cell, player, j)));
+        for (int box = 0; box < boxNum && !board.isDeadlock(cell); box++)
+            stateLits.push_back(make_pair(BoxLit(cell, box, i), BoxLit(cell, box, j)));
+    }
+    vector<Lit> differ;
+    for (const auto &[at, later] : stateLits)
+    {
+        if (Pruned(at) && Pruned(later))
+            continue;
+        Lit lit(layout.NewAuxVar());
+        AddClause({~lit, at, later});
+        AddClause({~lit, ~at, ~later});
+        differ.push_back(lit);
+    }
+    Clause &some = NewClause();
+    for (const Lit &lit : differ)
+        some.AddLit(lit);
+    AddClause(some);
+}
@@ -0,0 +1,174 @@
+#include "SokobanSolver.h"
+using namespace std;
+
+/*
+    Push-level encoding: frame t is the position after t pushes, so the
+    horizon counts pushes instead of player moves. It builds on the
+    occupancy literals O(c,t) and a single player P(c,t) standing where the
+    last push left it. Walking between two pushes is a reachability relation
+    over the cells that are free at frame t, unrolled in layers
+        R0(c,t) = P(c,t),  Rk(c,t) -> ~O(c,t) & (Rk-1(c,t) | OR_n Rk-1(n,t))
+    so a true top layer literal always has a real path behind it. Exactly one
+    push push(c,d,t) happens per frame; it needs the player to reach c.
+    MacroMoves() turns a model back into a move-level solution with BFS.
+*/
+
+void SokobanSolver::MacroConstraints()
+{
+    if (options.windows)
+        ComputeWindows(false); // the player walks freely between pushes
+    OccupancyInitState();
+    OccupancySolvedState();
+    int nCells = board.numCells();
+    int nLayers = max(0, (int)board.walkableCells().size() - 1);
+    actionVars.assign(stepLimit * nCells * 8, 0);
+    vector<Lit> reach(nCells), previous(nCells);
+    vector<Lit> pushes;
+    for (int t = 0; t < stepLimit; t++)
+    {
+        // reachability layers over the free cells of frame t
+        for (int cell : board.walkableCells())
+            reach[cell] = PlayerLit(cell, 0, t);
+        for (int k = 1; k <= nLayers; k++)
+        {
+            swap(reach, previous);
+            for (int cell : board.walkableCells())
+            {
+                reach[cell] = Lit(layout.NewAuxVar());
+                AddClause({~reach[cell], ~OccupancyLit(cell, t)});
+                Clause &support = NewClause();
+                support.AddLit(~reach[cell]);
+                support.AddLit(previous[cell]);
+                for (int dir = 0; dir < 4; dir++)
+                {
+                    int next = board.neighbour(cell, dir);
+                    if (next != -1 && board.isWalkable(next))
+                        support.AddLit(previous[next]);
+                }
+                AddClause(support);
+            }
+        }
+        // pushes from cell: the box on the neighbour moves one square further
+        pushes.clear();
+        for (int cell : board.walkableCells())
+        {
+            for (int dir = 0; dir < 4; dir++)
+            {
+                int next = board.neighbour(cell, dir);
+                int beyond = board.beyond(cell, dir);
+                if (next == -1 || beyond == -1 || !board.isWalkable(next) || !board.isWalkable(beyond) || board.isDeadlock(beyond))
+                    continue;
+                if (Pruned(OccupancyLit(next, t)) || Pruned(OccupancyLit(beyond, t + 1)))
+                    continue;
+                Lit push(layout.NewAuxVar());
+                actionVars[(t * nCells + cell) * 8 + 4 + dir] = push.var();
+                AddClause({~push, reach[cell]});
+                AddClause({~push, OccupancyLit(next, t)});
+                AddClause({~push, ~OccupancyLit(beyond, t)});
+                AddClause({~push, ~OccupancyLit(next, t + 1)});
+                AddClause({~push, OccupancyLit(beyond, t + 1)});
+                AddClause({~push, PlayerLit(next, 0, t + 1)});
+                pushes.push_back(push);
+            }
+        }
+        Clause &some = NewClause();
+        for (const Lit &push : pushes)
+            some.AddLit(push);
+        AddClause(some);
+        AtMostOne(pushes);
+        // frame axioms: the player stands where the box was, boxes only move by the push
+        for (int cell : board.walkableCells())
+        {
+            Clause &player = NewClause();
+            player.AddLit(~PlayerLit(cell, 0, t + 1));
+            for (int dir = 0; dir < 4; dir++)
+            {
+                int from = board.neighbour(cell, Board::Opposite(dir));
+                if (from != -1 && actionVars[(t * nCells + from) * 8 + 4 + dir])
+                    player.AddLit(PushLit(from, 0, dir, t));
+            }
+            AddClause(player);
+            Clause &leave = NewClause();
+            leave.AddLit(~OccupancyLit(cell, t));
+            leave.AddLit(OccupancyLit(cell, t + 1));
+            for (int dir = 0; dir < 4; dir++)
+            {
+                int from = board.neighbour(cell, Board::Opposite(dir));
+                if (from != -1 && actionVars[(t * nCells + from) * 8 + 4 + dir])
+                    leave.AddLit(PushLit(from, 0, dir, t));
+            }
+            AddClause(leave);
+            Clause &enter = NewClause();
+            enter.AddLit(OccupancyLit(cell, t));
+            enter.AddLit(~OccupancyLit(cell, t + 1));
+            for (int dir = 0; dir < 4; dir++)
+            {
+                int from = board.beyond(cell, Board::Opposite(dir));
+                if (from != -1 && actionVars[(t * nCells + from) * 8 + 4 + dir])
+                    enter.AddLit(PushLit(from, 0, dir, t));
+            }
+            AddClause(enter);
+        }
+    }
+}
+
+string SokobanSolver::MacroMoves(const SatBackend &sat) const
+{
+    static const char moveLetters[4] = {'u', 'd', 'l', 'r'};
+    static const char pushLetters[4] = {'U', 'D', 'L', 'R'};
+    int nCells = board.numCells();
+    string moves;
+    for (int t = 0; t < stepLimit; t++)
+    {
+        int player = -1, pushCell = -1, pushDir = -1;
+        vector<bool> occupied(nCells, false);
+        for (int cell : board.walkableCells())
+        {
+            if (sat.VarValue(PlayerLit(cell, 0, t).var()))
+                player = cell;
+            occupied[cell] = sat.VarValue(OccupancyLit(cell, t).var());
+            for (int dir = 0; dir < 4; dir++)
+            {
+                int var = actionVars[(t * nCells + cell) * 8 + 4 + dir];
+                if (var && sat.VarValue(var))
+                {
+                    pushCell = cell;
+                    pushDir = dir;
+                }
+            }
+        }
+        if (player == -1 || pushCell == -1)
+            return moves;
+        // shortest walk to the pushing cell around the boxes of frame t
+        vector<int> parentDir(nCells, -1);
+        vector<bool> visited(nCells, false);
+        queue<int> frontier;
+        frontier.push(player);
+        visited[player] = true;
+        while (!frontier.empty() && !visited[pushCell])
+        {
+            int cell = frontier.front();
+            frontier.pop();
+            for (int dir = 0; dir < 4; dir++)
+            {
+                int next = board.neighbour(cell, dir);
+                if (next == -1 || visited[next] || occupied[next] || !board.isWalkable(next))
+                    continue;
+                visited[next] = true;
+                parentDir[next] = dir;
+                frontier.push(next);
+            }
+        }
+        if (!visited[pushCell])
+        {
+            cerr << "Error: the model pushes from a cell the player cannot reach at push " << t << "." << endl;
+            return moves;
+        }
+        string walk;
+        for (int cell = pushCell; cell != player; cell = board.neighbour(cell, Board::Opposite(parentDir[cell])))
+            walk += moveLetters[parentDir[cell]];
+        moves.append(walk.rbegin(), walk.rend());
+        moves += pushLetters[pushDir];
+    }
+    return moves;
+}
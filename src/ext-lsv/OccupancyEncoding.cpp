@@ -0,0 +1,138 @@
+#include "SokobanSolver.h"
+using namespace std;
+
+/*
+    Box-identity-free encoding: a single variable O(c,t) says that some box
+    occupies cell c at time t (box slot 0 of the layout). The goal only asks
+    for occupied targets, so nothing is lost, and the boxNum! permutations
+    of box indices disappear from the search space. Boxes are conserved by
+    the push relation: a box only leaves a cell when a player walks onto it,
+    it then reappears one square further, and it only appears on a cell when
+    pushed there. Dead squares can be pushed out of but never into.
+*/
+
+void SokobanSolver::OccupancyInitState()
+{
+    for (int player = 0; player < playerNum; player++)
+    {
+        int start = board.cellId(mapInfo.at("Players")[player].first, mapInfo.at("Players")[player].second);
+        for (int cell = 0; cell < board.numCells(); cell++)
+            AddClause({cell == start ? PlayerLit(cell, player, 0) : ~PlayerLit(cell, player, 0)});
+    }
+    vector<bool> occupied(board.numCells(), false);
+    for (const auto &[row, col] : mapInfo.at("Boxes"))
+        occupied[board.cellId(row, col)] = true;
+    for (int cell = 0; cell < board.numCells(); cell++)
+        AddClause({occupied[cell] ? OccupancyLit(cell, 0) : ~OccupancyLit(cell, 0)});
+}
+
+void SokobanSolver::OccupancySolvedState()
+{
+    for (int target : board.targetCells())
+        AddClause({OccupancyLit(target, stepLimit)});
+}
+
+void SokobanSolver::OccupancyPushConstraints()
+{
+    for (int t = 0; t < stepLimit; t++)
+    {
+        for (int player = 0; player < playerNum; player++)
+        {
+            for (int cell : board.walkableCells())
+            {
+                for (int dir = 0; dir < 4; dir++)
+                {
+                    // walking from cell onto an occupied neighbour pushes the box one square further
+                    int next = board.neighbour(cell, dir);
+                    if (next == -1 || !board.isWalkable(next))
+                        continue;
+                    int beyond = board.beyond(cell, dir);
+                    Lit before = PlayerLit(cell, player, t);
+                    Lit after = PlayerLit(next, player, t + 1);
+                    Lit box = OccupancyLit(next, t);
+                    if (beyond == -1 || !board.isWalkable(beyond) || board.isDeadlock(beyond))
+                    {
+                        AddClause({~before, ~after, ~box});
+                        continue;
+                    }
+                    AddClause({~before, ~after, ~box, ~OccupancyLit(beyond, t)});
+                    AddClause({~before, ~after, ~box, OccupancyLit(beyond, t + 1)});
+                }
+            }
+        }
+    }
+}
+
+void SokobanSolver::OccupancyFrameAxioms()
+{
+    int nClausesBefore = nClauses;
+    int nVarsBefore = layout.numVars();
+    for (int t = 0; t < stepLimit; t++)
+    {
+        for (int cell : board.walkableCells())
+        {
+            // O(c,t) & ~O(c,t+1) -> a player walked onto c
+            Clause &leave = NewClause();
+            leave.AddLit(~OccupancyLit(cell, t));
+            leave.AddLit(OccupancyLit(cell, t + 1));
+            for (int player = 0; player < playerNum; player++)
+                leave.AddLit(PlayerLit(cell, player, t + 1));
+            AddClause(leave);
+            // ~O(c,t) & O(c,t+1) -> OR_{d,p} push(c,d,p,t), where
+            // push(c,d,p,t) -> O(from,t) & P(pusher,p,t) & P(from,p,t+1)
+            vector<Lit> pushes;
+            for (int dir = 0; dir < 4 && !board.isDeadlock(cell) && !Pruned(OccupancyLit(cell, t + 1)); dir++)
+            {
+                int from = board.neighbour(cell, dir);
+                int pusher = board.beyond(cell, dir);
+                if (from == -1 || pusher == -1 || !board.isWalkable(from) || !board.isWalkable(pusher))
+                    continue;
+                for (int player = 0; player < playerNum; player++)
+                {
+                    Lit push(layout.NewAuxVar());
+                    AddClause({~push, OccupancyLit(from, t)});
+                    AddClause({~push, PlayerLit(pusher, player, t)});
+                    AddClause({~push, PlayerLit(from, player, t + 1)});
+                    if (playerNum > 1)
+                        AddClause({push, ~OccupancyLit(from, t), ~PlayerLit(pusher, player, t), ~PlayerLit(from, player, t + 1)});
+                    pushes.push_back(push);
+                }
+            }
+            // two players pushing two boxes onto c would merge them into one literal;
+            // with the pushes defined both ways, at most one of them may happen
+            if (playerNum > 1)
+                AtMostOne(pushes);
+            Clause &enter = NewClause();
+            enter.AddLit(OccupancyLit(cell, t));
+            enter.AddLit(~OccupancyLit(cell, t + 1));
+            for (const Lit &push : pushes)
+                enter.AddLit(push);
+            AddClause(enter);
+        }
+    }
+    stats.frameClauses += nClauses - nClausesBefore;
+    stats.frameVars += layout.numVars() - nVarsBefore;
+}
+
+void SokobanSolver::OccupancyConstraints()
+{
+    if (options.windows)
+        ComputeWindows(true);
+    OccupancyInitState();
+    OccupancySolvedState();
+    PlayerMovementConstraints();
+    OccupancyPushConstraints();
+    OccupancyFrameAxioms();
+    PlayerSinglePlacementConstraints();
+    PlayerCollisionConstraints();
+    // players never stand on a box; unlike BoxAndPlayerCollisionConstraints() this includes dead squares
+    for (int t = 0; t <= stepLimit; t++)
+    {
+        for (int player = 0; player < playerNum; player++)
+        {
+            for (int cell : board.walkableCells())
+                AddClause({~OccupancyLit(cell, t), ~PlayerLit(cell, player, t)});
+        }
+    }
+    tunnelMacro();
+}
@@ -1,9 +1,11 @@
 #include "Preprocessor.h"
+#include <functional>
 #include <fstream>
 #include <iostream>
 #include <queue>
 #include <algorithm>
 #include <map>
+#include <limits>
 using namespace std;
 Preprocessor::Preprocessor(const string &filename, bool verbose) : filename(filename), verbose(verbose) {}
 
@@ -17,6 +19,11 @@ void Preprocessor::loadMap()
     const char walkableSymbol = ' ';
     const char box_on_targetSymbol = '*';
     const char player_on_targetSymbol = '+';
+    // older maps/ files spell the same squares with letters
+    const char legacyPlayerSymbol = 'P';
+    const char legacyWallSymbol = 'W';
+    const char legacyBoxSymbol = 'B';
+    const char legacyTargetSymbol = 'T';
 
     ifstream inFile(filename);
     if (!inFile.is_open())
@@ -25,6 +32,7 @@ void Preprocessor::loadMap()
         return;
     }
     string line;
+    vector<string> lines;
     int row = 0;
     int column = 0;
     while (getline(inFile, line))
@@ -34,6 +42,23 @@ void Preprocessor::loadMap()
             char c = line[col];
             switch (c)
             {
+            case legacyPlayerSymbol:
+                c = line[col] = playerSymbol;
+                break;
+            case legacyWallSymbol:
+                c = line[col] = wallSymbol;
+                break;
+            case legacyBoxSymbol:
+                c = line[col] = boxSymbol;
+                break;
+            case legacyTargetSymbol:
+                c = line[col] = targetSymbol;
+                break;
+            default:
+                break;
+            }
+            switch (c)
+            {
             case playerSymbol:
                 mapInfo["Players"].push_back(make_pair(row, col)); // player index in map info
                 break;
@@ -61,16 +86,40 @@ void Preprocessor::loadMap()
                 mapInfo["Walkable"].push_back(make_pair(row, col));
             // column = line.size();
         }
+        lines.push_back(line);
         column = max(column, (int)line.size());
         row++;
     }
     this->mapSize = make_pair(row, column);
     this->playerNum = mapInfo["Players"].size();
     this->boxNum = mapInfo["Boxes"].size();
+    // make sure the compatibility view has every key even if the map lacks it
+    for (const char *key : {"Players", "Walls", "Boxes", "Targets", "Walkable"})
+        mapInfo[key];
+
+    board = Board(mapSize.first, mapSize.second);
+    for (int r = 0; r < (int)lines.size(); r++)
+    {
+        for (int col = 0; col < (int)lines[r].size(); col++)
+        {
+            char c = lines[r][col];
+            if (c == wallSymbol)
+                board.addType(r, col, Board::WALL);
+            else
+                board.addType(r, col, Board::WALKABLE);
+            if (c == targetSymbol || c == box_on_targetSymbol || c == player_on_targetSymbol)
+                board.addType(r, col, Board::TARGET);
+        }
+    }
+    board.finalize();
     // cout << "Map Dimension: " << mapSize.first << ", " << mapSize.second << endl;
     // cout << "PlayerNum: " << playerNum << endl;
     // cout << "BoxNum: " << boxNum << endl;
     findDeadlockPos();
+    // the dead squares depend on walls and targets only, so these stay valid
+    // when a runner calls findDeadlockPos() again
+    computeDistances();
+    computeLowerBound();
 }
 
 void Preprocessor::findDeadlockPos()
@@ -128,15 +177,186 @@ void Preprocessor::findDeadlockPos()
 
     if (verbose)
         cout << "Num of dead lock box positions: " << deadlockPositions.size() << endl;
-    vector<vector<char>> deadLockBoxPosStr(mapSize.first, vector<char>(mapSize.second, ' '));
-    // deadLockBoxPosMap
-    deadlockPosMap = vector<vector<bool>>(mapSize.first, vector<bool>(mapSize.second, false));
+    board.clearDeadlocks();
     for (const auto &d : deadlockPositions)
+        board.markDeadlock(board.cellId(d.first, d.second));
+}
+
+void Preprocessor::computeDistances()
+{
+    int nCells = board.numCells();
+    // multi-source BFS; step(cell, dir) gives the next cell or -1
+    auto bfs = [&](const vector<int> &sources, const function<int(int, int)> &step)
+    {
+        vector<int> distance(nCells, -1);
+        queue<int> frontier;
+        for (int cell : sources)
+        {
+            distance[cell] = 0;
+            frontier.push(cell);
+        }
+        while (!frontier.empty())
+        {
+            int cell = frontier.front();
+            frontier.pop();
+            for (int dir = 0; dir < 4; dir++)
+            {
+                int next = step(cell, dir);
+                if (next == -1 || distance[next] != -1)
+                    continue;
+                distance[next] = distance[cell] + 1;
+                frontier.push(next);
+            }
+        }
+        return distance;
+    };
+    auto walk = [&](int cell, int dir)
+    {
+        int next = board.neighbour(cell, dir);
+        return next != -1 && board.isWalkable(next) ? next : -1;
+    };
+    // the player stands on the opposite side of the box and takes its place
+    auto push = [&](int cell, int dir)
+    {
+        int next = walk(cell, dir);
+        int behind = walk(cell, Board::Opposite(dir));
+        return next != -1 && behind != -1 && !board.isDeadlock(next) ? next : -1;
+    };
+    // the same push seen from its destination; dead squares are allowed as origins
+    // so a box that starts on one still gets a distance, but are never passed through
+    auto unpush = [&](int cell, int dir)
+    {
+        if (board.isDeadlock(cell))
+            return -1;
+        int from = walk(cell, dir);
+        int behind = from == -1 ? -1 : walk(from, dir);
+        return behind != -1 ? from : -1;
+    };
+    playerDistance.clear();
+    for (const auto &[row, col] : mapInfo["Players"])
+        playerDistance.push_back(bfs({board.cellId(row, col)}, walk));
+    boxDistance.clear();
+    for (const auto &[row, col] : mapInfo["Boxes"])
+        boxDistance.push_back(bfs({board.cellId(row, col)}, push));
+    goalDistance = bfs(board.targetCells(), unpush);
+}
+// Min-cost assignment of every row to a distinct column (rows <= columns) with the
+// Hungarian method and potentials, O(rows^2 * columns); returns the total cost.
+static long long MinCostAssignment(const vector<vector<long long>> &cost)
+{
+    int n = cost.size(), m = n ? cost[0].size() : 0;
+    const long long INF = numeric_limits<long long>::max() / 4;
+    // 1-based; column 0 is the virtual column of the row being inserted
+    vector<long long> u(n + 1, 0), v(m + 1, 0), minSlack(m + 1);
+    vector<int> rowOf(m + 1, 0), prevCol(m + 1, 0);
+    vector<bool> used(m + 1);
+    for (int row = 1; row <= n; row++)
+    {
+        rowOf[0] = row;
+        int col = 0;
+        fill(minSlack.begin(), minSlack.end(), INF);
+        fill(used.begin(), used.end(), false);
+        do
+        {
+            used[col] = true;
+            int r = rowOf[col], nextCol = 0;
+            long long delta = INF;
+            for (int j = 1; j <= m; j++)
+            {
+                if (used[j])
+                    continue;
+                long long slack = cost[r - 1][j - 1] - u[r] - v[j];
+                if (slack < minSlack[j])
+                {
+                    minSlack[j] = slack;
+                    prevCol[j] = col;
+                }
+                if (minSlack[j] < delta)
+                {
+                    delta = minSlack[j];
+                    nextCol = j;
+                }
+            }
+            for (int j = 0; j <= m; j++)
+            {
+                if (used[j])
+                {
+                    u[rowOf[j]] += delta;
+                    v[j] -= delta;
+                }
+                else
+                    minSlack[j] -= delta;
+            }
+            col = nextCol;
+        } while (rowOf[col] != 0);
+        // flip the augmenting path
+        do
+        {
+            int previous = prevCol[col];
+            rowOf[col] = rowOf[previous];
+            col = previous;
+        } while (col != 0);
+    }
+    long long total = 0;
+    for (int j = 1; j <= m; j++)
     {
-        int i = d.first;
-        int j = d.second;
-        deadlockPosMap[i][j] = true;
+        if (rowOf[j] != 0)
+            total += cost[rowOf[j] - 1][j - 1];
     }
+    return total;
+}
+void Preprocessor::computeLowerBound()
+{
+    pushLowerBound = moveLowerBound = 0;
+    const vector<int> &targets = board.targetCells();
+    if (boxDistance.empty() || boxDistance.size() > targets.size())
+        return;
+    // a box that cannot reach a target makes the level unsolvable; the bound stays 0 then
+    const long long unreachable = 1LL << 40;
+    vector<vector<long long>> cost(boxDistance.size(), vector<long long>(targets.size()));
+    int longest = 0; // pushes of the box farthest from every target
+    for (size_t box = 0; box < boxDistance.size(); box++)
+    {
+        int nearest = -1;
+        for (size_t j = 0; j < targets.size(); j++)
+        {
+            int d = boxDistance[box][targets[j]];
+            cost[box][j] = d == -1 ? unreachable : d;
+            if (d != -1 && (nearest == -1 || d < nearest))
+                nearest = d;
+        }
+        longest = max(longest, nearest);
+    }
+    long long pushes = MinCostAssignment(cost);
+    if (pushes >= unreachable)
+        return;
+    pushLowerBound = pushes;
+    if (pushes == 0)
+        return;
+    // the first push of any player follows a walk to the square behind some box
+    int walk = -1;
+    for (const auto &[row, col] : mapInfo["Boxes"])
+    {
+        int cell = board.cellId(row, col);
+        for (int dir = 0; dir < 4; dir++)
+        {
+            int next = board.neighbour(cell, dir);
+            int behind = board.neighbour(cell, Board::Opposite(dir));
+            if (next == -1 || behind == -1 || !board.isWalkable(next) || !board.isWalkable(behind) || board.isDeadlock(next))
+                continue;
+            for (const vector<int> &distance : playerDistance)
+            {
+                if (distance[behind] != -1 && (walk == -1 || distance[behind] < walk))
+                    walk = distance[behind];
+            }
+        }
+    }
+    // each frame holds at most one push per player, and a box is pushed once per frame
+    int nPlayers = max(1, (int)playerDistance.size());
+    int frames = max((pushLowerBound + nPlayers - 1) / nPlayers, longest);
+    moveLowerBound = max(0, walk) + frames;
+    if (verbose)
+        cout << "Lower bound: " << pushLowerBound << " pushes, " << moveLowerBound << " moves" << endl;
 }
 void Preprocessor::bfs(vector<vector<char>> &underlyingTiles, vector<vector<bool>> &visited, vector<pair<int, int>> &group, int i, int j)
 {
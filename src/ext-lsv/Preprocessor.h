@@ -10,6 +10,7 @@
 
 #include <string>
 #include <algorithm>
+#include "Board.h"
 
 using namespace std;
 
@@ -38,26 +39,52 @@ public:
     void bfs(vector<vector<char>> &underlyingTiles, vector<vector<bool>> &visited, vector<pair<int, int>> &group, int i, int j);
     const vector<pair<int, int>> &getDeadlockPositions() const { return deadlockPositions; }
     /*
+    ============ Distance Windows ============
+    */
+    // BFS distances over cell ids, -1 when unreachable. Players walk around walls only;
+    // boxes are pushed (the square behind must be free of walls) and never onto dead squares.
+    void computeDistances(); // run once by loadMap()
+    const vector<int> &getPlayerDistances(int player) const { return playerDistance[player]; } // moves from the start
+    const vector<int> &getBoxDistances(int box) const { return boxDistance[box]; }             // pushes from the start
+    const vector<int> &getGoalDistances() const { return goalDistance; }                       // pushes to the nearest target
+    /*
+    ============ Lower Bound ============
+    */
+    // Admissible bounds on the length of any solution, run once by loadMap(). The pushes
+    // are a min-cost matching of boxes to targets over the push distances; the moves add the
+    // walk of the player to the first push. With several players the pushes are shared out.
+    void computeLowerBound();
+    int getPushLowerBound() const { return pushLowerBound; }
+    int getMoveLowerBound() const { return moveLowerBound; }
+    /*
     ============ Getters & Conditioners ============
     */
-    const unordered_map<string, vector<pair<int, int>>> &get_mapInfo() const { return mapInfo; };
+    const Board &get_board() const { return board; }
+    const unordered_map<string, vector<pair<int, int>>> &get_mapInfo() const { return mapInfo; }; // compatibility view of the board
     const pair<int, int> get_mapSize() const { return mapSize; };
-    inline bool notWall(int row, int col) const { return find(mapInfo.at("Walls").begin(), mapInfo.at("Walls").end(), make_pair(row, col)) == mapInfo.at("Walls").end(); }
-    inline bool isWall(int row, int col) const { return find(mapInfo.at("Walls").begin(), mapInfo.at("Walls").end(), make_pair(row, col)) != mapInfo.at("Walls").end(); }
-    inline bool isWalkable(int row, int col) const { return find(mapInfo.at("Walkable").begin(), mapInfo.at("Walkable").end(), make_pair(row, col)) != mapInfo.at("Walkable").end(); }
-    inline bool isTarget(int row, int col) const { return mapInfo.at("Targets").end() != find(mapInfo.at("Targets").begin(), mapInfo.at("Targets").end(), make_pair(row, col)); }
-    inline bool isDeadLockBoxPos(int row, int col) const { return deadlockPosMap[row][col]; }
+    int get_playerNum() const { return playerNum; }
+    int get_boxNum() const { return boxNum; }
+    inline bool notWall(int row, int col) const { return !board.isWall(row, col); }
+    inline bool isWall(int row, int col) const { return board.isWall(row, col); }
+    inline bool isWalkable(int row, int col) const { return board.isWalkable(row, col); }
+    inline bool isTarget(int row, int col) const { return board.isTarget(row, col); }
+    inline bool isDeadLockBoxPos(int row, int col) const { return board.isDeadlock(row, col); }
 
 private:
     string filename;
     vector<vector<char>> map;
+    Board board;
     unordered_map<string, vector<pair<int, int>>> mapInfo;
     vector<vector<pair<int, int>>> pullableRegions; // Direct vector of regions
     vector<vector<bool>> pullablePosMap;            // Fast lookup map for pullable positions
     set<pair<int, int>> pullable_set;
     set<vector<pair<int, int>>> tunnels = {};
     vector<pair<int, int>> deadlockPositions;
-    vector<vector<bool>> deadlockPosMap;
+    vector<vector<int>> playerDistance;
+    vector<vector<int>> boxDistance;
+    vector<int> goalDistance;
+    int pushLowerBound = 0;
+    int moveLowerBound = 0;
     pair<int, int> mapSize;
     int playerNum;
     int boxNum;
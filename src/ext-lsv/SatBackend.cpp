@@ -0,0 +1,256 @@
+#include "SatBackend.h"
+#include "ClauseSharing.h"
+#include <vector>
+#include <unordered_set>
+#include "sat/bsat/satSolver.h"
+#include "sat/glucose2/AbcGlucose2.h"
+#include "sat/satoko/satoko.h"
+using namespace std;
+
+// AbcGlucose.h shares its include guard (and Glucose_CreatePars) with
+// AbcGlucose2.h, so the few glucose functions used here are declared directly
+ABC_NAMESPACE_HEADER_START
+typedef void bmcg_sat_solver;
+extern bmcg_sat_solver *bmcg_sat_solver_start();
+extern void bmcg_sat_solver_stop(bmcg_sat_solver *s);
+extern int bmcg_sat_solver_addclause(bmcg_sat_solver *s, int *plits, int nlits);
+extern int bmcg_sat_solver_solve(bmcg_sat_solver *s, int *plits, int nlits);
+extern int bmcg_sat_solver_final(bmcg_sat_solver *s, int **ppArray);
+extern void bmcg_sat_solver_set_nvars(bmcg_sat_solver *s, int nvars);
+extern int bmcg_sat_solver_read_cex_varvalue(bmcg_sat_solver *s, int ivar);
+extern void bmcg_sat_solver_set_stop(bmcg_sat_solver *s, int *pstop);
+extern abctime bmcg_sat_solver_set_runtime_limit(bmcg_sat_solver *s, abctime Limit);
+extern void bmcg_sat_solver_set_conflict_budget(bmcg_sat_solver *s, int Limit);
+extern int bmcg_sat_solver_varnum(bmcg_sat_solver *s);
+extern int bmcg_sat_solver_clausenum(bmcg_sat_solver *s);
+extern int bmcg_sat_solver_conflictnum(bmcg_sat_solver *s);
+ABC_NAMESPACE_HEADER_END
+
+const char *SatBackendName(SatBackendType type)
+{
+    switch (type)
+    {
+    case SatBackendType::Bsat:
+        return "bsat";
+    case SatBackendType::Glucose2:
+        return "glucose2";
+    case SatBackendType::Satoko:
+        return "satoko";
+    case SatBackendType::Glucose:
+        return "glucose";
+    case SatBackendType::Sharing:
+        return "sharing";
+    }
+    return "unknown";
+}
+
+bool ParseSatBackend(const string &name, SatBackendType &type)
+{
+    for (SatBackendType t : {SatBackendType::Bsat, SatBackendType::Glucose2, SatBackendType::Satoko, SatBackendType::Glucose, SatBackendType::Sharing})
+    {
+        if (name == SatBackendName(t))
+        {
+            type = t;
+            return true;
+        }
+    }
+    return false;
+}
+
+/* ============ bsat ============ */
+
+// bsat polls a callback with its run id instead of a flag; the callback
+// runs on the thread inside Solve(), so the flag is handed over per thread
+static thread_local int *pBsatStop = nullptr;
+static int BsatStop(int) { return pBsatStop && *pBsatStop; }
+
+class BsatBackend : public SatBackend
+{
+public:
+    BsatBackend() : pSat(sat_solver_new()) {}
+    ~BsatBackend() override { sat_solver_delete(pSat); }
+    SatBackendType type() const override { return SatBackendType::Bsat; }
+    void SetNumVars(int nVars) override { sat_solver_setnvars(pSat, nVars); }
+    int VarValue(int var) const override { return var < pSat->size && sat_solver_var_value(pSat, var); }
+    int FinalConflict(int **ppLits) override { return sat_solver_final(pSat, ppLits); }
+    void SetStop(int *pStop) override { this->pStop = pStop; }
+    void SetRuntimeLimit(abctime nTimeToStop) override { sat_solver_set_runtime_limit(pSat, nTimeToStop); }
+    void Diversify(int seed) override
+    {
+        // another stream of the 2% random decisions
+        pSat->random_seed = 91648253 + seed;
+        sat_solver_set_random(pSat, 0);
+    }
+    SatStats Stats() const override
+    {
+        SatStats stats;
+        stats.vars = sat_solver_nvars(pSat);
+        stats.clauses = sat_solver_nclauses(pSat);
+        stats.conflicts = sat_solver_nconflicts(pSat);
+        return stats;
+    }
+
+protected:
+    bool AddClauseImpl(const int *begin, const int *end) override { return sat_solver_addclause(pSat, (lit *)begin, (lit *)end); }
+    int SolveImpl(const int *assumpBegin, const int *assumpEnd) override
+    {
+        pBsatStop = pStop;
+        sat_solver_set_stop_func(pSat, pStop ? BsatStop : nullptr);
+        int status = sat_solver_solve(pSat, (lit *)assumpBegin, (lit *)assumpEnd, nConfLimit, 0, 0, 0);
+        pBsatStop = nullptr;
+        return status;
+    }
+
+private:
+    sat_solver *pSat;
+    int *pStop = nullptr;
+};
+
+/* ============ glucose2 ============ */
+
+class Glucose2Backend : public SatBackend
+{
+public:
+    Glucose2Backend() : pSat(bmcg2_sat_solver_start()) {}
+    ~Glucose2Backend() override { bmcg2_sat_solver_stop(pSat); }
+    SatBackendType type() const override { return SatBackendType::Glucose2; }
+    void SetNumVars(int nVars) override { bmcg2_sat_solver_set_nvars(pSat, nVars); }
+    int VarValue(int var) const override { return var < bmcg2_sat_solver_varnum(pSat) && bmcg2_sat_solver_read_cex_varvalue(pSat, var); }
+    int FinalConflict(int **ppLits) override { return bmcg2_sat_solver_final(pSat, ppLits); }
+    void SetStop(int *pStop) override { bmcg2_sat_solver_set_stop(pSat, pStop); }
+    void SetRuntimeLimit(abctime nTimeToStop) override { bmcg2_sat_solver_set_runtime_limit(pSat, nTimeToStop); }
+    SatStats Stats() const override
+    {
+        SatStats stats;
+        stats.vars = bmcg2_sat_solver_varnum(pSat);
+        stats.clauses = bmcg2_sat_solver_clausenum(pSat);
+        stats.conflicts = bmcg2_sat_solver_conflictnum(pSat);
+        return stats;
+    }
+
+protected:
+    bool AddClauseImpl(const int *begin, const int *end) override { return bmcg2_sat_solver_addclause(pSat, (int *)begin, end - begin); }
+    int SolveImpl(const int *assumpBegin, const int *assumpEnd) override
+    {
+        bmcg2_sat_solver_set_conflict_budget(pSat, nConfLimit);
+        return bmcg2_sat_solver_solve(pSat, (int *)assumpBegin, assumpEnd - assumpBegin);
+    }
+
+private:
+    bmcg2_sat_solver *pSat;
+};
+
+/* ============ satoko ============ */
+
+class SatokoBackend : public SatBackend
+{
+public:
+    SatokoBackend() : pSat(satoko_create()) {}
+    ~SatokoBackend() override { satoko_destroy(pSat); }
+    SatBackendType type() const override { return SatBackendType::Satoko; }
+    void SetNumVars(int nVars) override
+    {
+        // satoko_setnvars() starts the saved phase at true, so variables that occur in
+        // no clause, like the pruned ones, would read as true; the other solvers give false
+        for (int var = satoko_varnum(pSat); var < nVars; var++)
+            satoko_add_variable(pSat, SATOKO_LIT_FALSE);
+    }
+    int VarValue(int var) const override { return var < satoko_varnum(pSat) && satoko_read_cex_varvalue(pSat, var); }
+    int FinalConflict(int **ppLits) override { return satoko_final_conflict(pSat, ppLits); }
+    void SetStop(int *pStop) override { satoko_set_stop(pSat, pStop); }
+    void SetRuntimeLimit(abctime nTimeToStop) override { satoko_set_runtime_limit(pSat, nTimeToStop); }
+    void Diversify(int seed) override
+    {
+        // odd seeds restart more eagerly, even ones less, both decay activities faster
+        if (seed == 0)
+            return;
+        satoko_opts_t *opts = satoko_options(pSat);
+        opts->f_rst = seed % 2 ? 0.7 : 0.9;
+        opts->b_rst = seed % 2 ? 1.2 : 1.6;
+        opts->var_decay = 0.95 - 0.01 * min(seed, 5);
+    }
+    bool ExportLearnts(int maxLbd, int maxSize, vector<int> &clauses) override
+    {
+        Satoko_ExportLearnts(pSat, maxLbd, maxSize, exported, clauses);
+        return true;
+    }
+    SatStats Stats() const override
+    {
+        SatStats stats;
+        stats.vars = satoko_varnum(pSat);
+        stats.clauses = satoko_clausenum(pSat);
+        stats.conflicts = satoko_stats(pSat)->n_conflicts_all;
+        return stats;
+    }
+
+protected:
+    bool AddClauseImpl(const int *begin, const int *end) override
+    {
+        // satoko sorts the literals in place
+        buffer.assign(begin, end);
+        return satoko_add_clause(pSat, buffer.data(), buffer.size()) != SATOKO_ERR;
+    }
+    int SolveImpl(const int *assumpBegin, const int *assumpEnd) override
+    {
+        // satoko clears its per-call statistics before searching, so the limit
+        // is relative to this call (satoko_solve_assumptions_limit() is not)
+        satoko_options(pSat)->conf_limit = nConfLimit;
+        return satoko_solve_assumptions(pSat, (int *)assumpBegin, assumpEnd - assumpBegin);
+    }
+
+private:
+    satoko_t *pSat;
+    vector<int> buffer;
+    unordered_set<size_t> exported; // hashes of the clauses ExportLearnts() returned
+};
+
+/* ============ glucose ============ */
+
+class GlucoseBackend : public SatBackend
+{
+public:
+    GlucoseBackend() : pSat(bmcg_sat_solver_start()) {}
+    ~GlucoseBackend() override { bmcg_sat_solver_stop(pSat); }
+    SatBackendType type() const override { return SatBackendType::Glucose; }
+    void SetNumVars(int nVars) override { bmcg_sat_solver_set_nvars(pSat, nVars); }
+    int VarValue(int var) const override { return var < bmcg_sat_solver_varnum(pSat) && bmcg_sat_solver_read_cex_varvalue(pSat, var); }
+    int FinalConflict(int **ppLits) override { return bmcg_sat_solver_final(pSat, ppLits); }
+    void SetStop(int *pStop) override { bmcg_sat_solver_set_stop(pSat, pStop); }
+    void SetRuntimeLimit(abctime nTimeToStop) override { bmcg_sat_solver_set_runtime_limit(pSat, nTimeToStop); }
+    SatStats Stats() const override
+    {
+        SatStats stats;
+        stats.vars = bmcg_sat_solver_varnum(pSat);
+        stats.clauses = bmcg_sat_solver_clausenum(pSat);
+        stats.conflicts = bmcg_sat_solver_conflictnum(pSat);
+        return stats;
+    }
+
+protected:
+    bool AddClauseImpl(const int *begin, const int *end) override { return bmcg_sat_solver_addclause(pSat, (int *)begin, end - begin); }
+    int SolveImpl(const int *assumpBegin, const int *assumpEnd) override
+    {
+        bmcg_sat_solver_set_conflict_budget(pSat, nConfLimit);
+        return bmcg_sat_solver_solve(pSat, (int *)assumpBegin, assumpEnd - assumpBegin);
+    }
+
+private:
+    bmcg_sat_solver *pSat;
+};
+
+SatBackend *NewSatBackend(SatBackendType type, int nThreads)
+{
+    switch (type)
+    {
+    case SatBackendType::Sharing:
+        return new SharingBackend(nThreads);
+    case SatBackendType::Glucose2:
+        return new Glucose2Backend();
+    case SatBackendType::Satoko:
+        return new SatokoBackend();
+    case SatBackendType::Glucose:
+        return new GlucoseBackend();
+    default:
+        return new BsatBackend();
+    }
+}
@@ -0,0 +1,83 @@
+#ifndef SAT_BACKEND_H
+#define SAT_BACKEND_H
+
+#include <string>
+#include <vector>
+#include "sat/bsat/satVec.h"
+#include "ClauseSink.h"
+
+using namespace std;
+
+/*
+    Thin interface over the SAT solvers that ship with ABC, so that a run
+    type does not depend on one of them. Literals are in ABC encoding
+    (2 * var + sign) for every backend, results are l_True, l_False and
+    l_Undef as in bsat. A backend is also the ClauseSink the generators
+    stream into; clauses it rejects because the instance became UNSAT are
+    counted, see numFailed().
+*/
+enum class SatBackendType
+{
+    Bsat,     // src/sat/bsat, MiniSat 1.14 style
+    Glucose2, // src/sat/glucose2, bmcg2_sat_solver_*
+    Satoko,   // src/sat/satoko
+    Glucose,  // src/sat/glucose, bmcg_sat_solver_*
+    Sharing   // satoko instances on threads exchanging learnt clauses, see ClauseSharing.h
+};
+
+const char *SatBackendName(SatBackendType type);
+bool ParseSatBackend(const string &name, SatBackendType &type);
+
+// counters of the underlying solver
+struct SatStats
+{
+    int vars = 0;
+    int clauses = 0;   // original clauses kept by the solver
+    int conflicts = 0; // over all Solve() calls
+    int shared = 0;    // learnt clauses published to the other threads, Sharing only
+    int imported = 0;  // learnt clauses received from the other threads, Sharing only
+};
+
+class SatBackend : public ClauseSink
+{
+public:
+    virtual ~SatBackend() {}
+    virtual SatBackendType type() const = 0;
+    virtual void SetNumVars(int nVars) = 0; // variables 0 .. nVars - 1 exist; adding clauses also grows the solver
+    void AddClause(const int *begin, const int *end) override
+    {
+        if (!AddClauseImpl(begin, end))
+            nFailed++;
+    }
+    int numFailed() const { return nFailed; } // clauses rejected because the instance became UNSAT
+    // l_True, l_False, or l_Undef when a budget ran out or the stop flag was raised
+    int Solve(const int *assumpBegin = nullptr, const int *assumpEnd = nullptr)
+    {
+        // some solvers refuse to run once a clause was rejected
+        return nFailed > 0 ? l_False : SolveImpl(assumpBegin, assumpEnd);
+    }
+    virtual int VarValue(int var) const = 0;  // 1 if var is true in the last model
+    virtual int FinalConflict(int **ppLits) = 0; // after l_False under assumptions: negated assumptions responsible
+    // limits of the next Solve() calls
+    virtual void SetStop(int *pStop) = 0;     // Solve() gives up once *pStop != 0, nullptr to clear
+    void SetConflictBudget(int nConfLimit) { this->nConfLimit = nConfLimit; } // conflicts per Solve() call, 0 = none
+    virtual void SetRuntimeLimit(abctime nTimeToStop) = 0; // Abc_Clock() deadline, 0 = none
+    virtual SatStats Stats() const = 0;
+    virtual void Diversify(int seed) {} // perturb the heuristics for a portfolio, seed 0 keeps the defaults
+    // appends the learnt clauses with lbd <= maxLbd and size <= maxSize that were not
+    // exported before to clauses, each as its size followed by its literals;
+    // false when the solver does not give access to its learnt clauses
+    virtual bool ExportLearnts(int maxLbd, int maxSize, vector<int> &clauses) { return false; }
+
+protected:
+    virtual bool AddClauseImpl(const int *begin, const int *end) = 0;
+    virtual int SolveImpl(const int *assumpBegin, const int *assumpEnd) = 0;
+    int nConfLimit = 0;
+
+private:
+    int nFailed = 0;
+};
+
+SatBackend *NewSatBackend(SatBackendType type, int nThreads = 0); // nThreads: Sharing only, 0 = one per hardware thread
+
+#endif // SAT_BACKEND_H
@@ -0,0 +1,174 @@
+#include "SokobanAig.h"
+#include "aig/gia/giaAig.h"
+#include "aig/saig/saig.h"
+#include "proof/ssw/ssw.h"
+using namespace std;
+
+SokobanAig::SokobanAig(const Preprocessor &preprocessor) : board(preprocessor.get_board())
+{
+    const auto &mapInfo = preprocessor.get_mapInfo();
+    playerStart = board.cellId(mapInfo.at("Players")[0].first, mapInfo.at("Players")[0].second);
+    for (const auto &[row, col] : mapInfo.at("Boxes"))
+        boxStarts.push_back(board.cellId(row, col));
+    regOf.assign(board.numCells(), -1);
+    for (size_t i = 0; i < board.walkableCells().size(); i++)
+        regOf[board.walkableCells()[i]] = i;
+}
+
+Gia_Man_t *SokobanAig::Build() const
+{
+    const vector<int> &cells = board.walkableCells();
+    int nCells = cells.size();
+    Gia_Man_t *p = Gia_ManStart(64 * nCells + 100);
+    p->pName = Abc_UtilStrsav((char *)"sokoban");
+    Gia_ManHashAlloc(p);
+    int bit0 = Gia_ManAppendCi(p);
+    int bit1 = Gia_ManAppendCi(p);
+    // directions in Board order: up, down, left, right
+    int dirLits[4] = {Gia_ManHashAnd(p, Abc_LitNot(bit0), Abc_LitNot(bit1)), Gia_ManHashAnd(p, bit0, Abc_LitNot(bit1)),
+                      Gia_ManHashAnd(p, Abc_LitNot(bit0), bit1), Gia_ManHashAnd(p, bit0, bit1)};
+    vector<int> playerInit(nCells, 0), boxInit(nCells, 0);
+    playerInit[regOf[playerStart]] = 1;
+    for (int cell : boxStarts)
+        boxInit[regOf[cell]] = 1;
+    vector<int> player(nCells), box(nCells);
+    for (int i = 0; i < nCells; i++)
+        player[i] = Abc_LitNotCond(Gia_ManAppendCi(p), playerInit[i]);
+    for (int i = 0; i < nCells; i++)
+        box[i] = Abc_LitNotCond(Gia_ManAppendCi(p), boxInit[i]);
+    // arrive[i * 4 + dir]: the player steps onto cell i moving in dir, pushing the box
+    // there one cell further if there is one
+    vector<int> arrive(nCells * 4, 0);
+    int moved = 0;
+    for (int i = 0; i < nCells; i++)
+    {
+        for (int dir = 0; dir < 4; dir++)
+        {
+            int from = board.neighbour(cells[i], Board::Opposite(dir));
+            if (from == -1 || regOf[from] == -1)
+                continue;
+            int next = board.neighbour(cells[i], dir);
+            int pushable = 0;
+            if (next != -1 && regOf[next] != -1 && !board.isDeadlock(next))
+                pushable = Abc_LitNot(box[regOf[next]]);
+            int enter = Gia_ManHashOr(p, Abc_LitNot(box[i]), pushable);
+            arrive[i * 4 + dir] = Gia_ManHashAnd(p, dirLits[dir], Gia_ManHashAnd(p, player[regOf[from]], enter));
+            moved = Gia_ManHashOr(p, moved, arrive[i * 4 + dir]);
+        }
+    }
+    // every target covered, as in SokobanSolver::SolvedState()
+    int solved = 1;
+    for (int target : board.targetCells())
+        solved = Gia_ManHashAnd(p, solved, regOf[target] == -1 ? 0 : box[regOf[target]]);
+    Gia_ManAppendCo(p, solved);
+    for (int i = 0; i < nCells; i++)
+    {
+        int next = Gia_ManHashAnd(p, player[i], Abc_LitNot(moved));
+        for (int dir = 0; dir < 4; dir++)
+            next = Gia_ManHashOr(p, next, arrive[i * 4 + dir]);
+        Gia_ManAppendCo(p, Abc_LitNotCond(next, playerInit[i]));
+    }
+    for (int i = 0; i < nCells; i++)
+    {
+        int leave = 0, enter = 0;
+        for (int dir = 0; dir < 4; dir++)
+        {
+            leave = Gia_ManHashOr(p, leave, arrive[i * 4 + dir]);
+            int from = board.neighbour(cells[i], Board::Opposite(dir));
+            if (from != -1 && regOf[from] != -1)
+                enter = Gia_ManHashOr(p, enter, Gia_ManHashAnd(p, arrive[regOf[from] * 4 + dir], box[regOf[from]]));
+        }
+        int next = Gia_ManHashOr(p, Gia_ManHashAnd(p, box[i], Abc_LitNot(leave)), enter);
+        Gia_ManAppendCo(p, Abc_LitNotCond(next, boxInit[i]));
+    }
+    Gia_ManSetRegNum(p, 2 * nCells);
+    Gia_ManHashStop(p);
+    Gia_Man_t *pTemp;
+    p = Gia_ManCleanup(pTemp = p);
+    Gia_ManStop(pTemp);
+    return p;
+}
+
+string SokobanAig::CexToMoves(const Abc_Cex_t *pCex, bool &solved) const
+{
+    static const char moveLetters[4] = {'u', 'd', 'l', 'r'};
+    static const char pushLetters[4] = {'U', 'D', 'L', 'R'};
+    int player = playerStart;
+    vector<bool> occupied(board.numCells(), false);
+    for (int cell : boxStarts)
+        occupied[cell] = true;
+    string moves;
+    // the output depends on the registers only, so the inputs of the failing frame do not matter
+    for (int f = 0; f < pCex->iFrame; f++)
+    {
+        int base = pCex->nRegs + f * pCex->nPis;
+        int dir = Abc_InfoHasBit((unsigned *)pCex->pData, base) | (Abc_InfoHasBit((unsigned *)pCex->pData, base + 1) << 1);
+        int next = board.neighbour(player, dir);
+        if (next == -1 || regOf[next] == -1)
+            continue;
+        if (occupied[next])
+        {
+            int beyond = board.neighbour(next, dir);
+            if (beyond == -1 || regOf[beyond] == -1 || board.isDeadlock(beyond) || occupied[beyond])
+                continue;
+            occupied[next] = false;
+            occupied[beyond] = true;
+            moves += pushLetters[dir];
+        }
+        else
+            moves += moveLetters[dir];
+        player = next;
+    }
+    solved = true;
+    for (int target : board.targetCells())
+    {
+        if (!occupied[target])
+            solved = false;
+    }
+    return moves;
+}
+
+vector<StateInvariant> SokobanAig::MineInvariants() const
+{
+    const vector<int> &cells = board.walkableCells();
+    int nCells = cells.size();
+    vector<bool> init(2 * nCells, false);
+    init[regOf[playerStart]] = true;
+    for (int cell : boxStarts)
+        init[nCells + regOf[cell]] = true;
+    Gia_Man_t *pGia = Build();
+    Aig_Man_t *pAig = Gia_ManToAigSimple(pGia);
+    Gia_ManStop(pGia);
+    Ssw_Pars_t Pars;
+    Ssw_ManSetDefaultParams(&Pars);
+    Aig_ManStop(Ssw_SignalCorrespondence(pAig, &Pars));
+    // the classes stay on pAig. Registers reset to 0 and constant 1 has phase 1, so
+    // a register in the class of the constant is always 0, and two registers in one
+    // class are equal; the stored values are complemented where the start is 1
+    vector<StateInvariant> invariants;
+    Aig_Obj_t *pObj;
+    int i;
+    Saig_ManForEachLo(pAig, pObj, i)
+    {
+        Aig_Obj_t *pRepr = Aig_ObjRepr(pAig, pObj);
+        if (pRepr == nullptr)
+            continue;
+        StateInvariant inv;
+        inv.cell = cells[i % nCells];
+        inv.box = i >= nCells;
+        if (pRepr == Aig_ManConst1(pAig))
+            inv.value = init[i];
+        else if (Saig_ObjIsLo(pAig, pRepr))
+        {
+            int j = Saig_ObjRegId(pAig, pRepr);
+            inv.otherCell = cells[j % nCells];
+            inv.otherBox = j >= nCells;
+            inv.value = init[i] == init[j];
+        }
+        else
+            continue; // equivalent to logic only
+        invariants.push_back(inv);
+    }
+    Aig_ManStop(pAig);
+    return invariants;
+}
@@ -0,0 +1,42 @@
+#ifndef SOKOBAN_AIG_H
+#define SOKOBAN_AIG_H
+
+#include <string>
+#include <vector>
+#include "aig/gia/gia.h"
+#include "Preprocessor.h"
+#include "SokobanSolver.h"
+
+using namespace std;
+
+/*
+    The level as a sequential AIG for the model checkers of ABC (bmc3,
+    &bmcs, &bmcg, pdr, ...). There is one register per walkable cell for the
+    player and one for "a box is here". The two primary inputs of a frame
+    select the direction of the move, and the only output is "every target
+    is covered by a box". A move into a wall, or a push that is blocked or would put
+    the box on a dead square, keeps the state unchanged. So the first frame
+    at which the output can be 1 is the length of an optimal solution.
+    Registers start at 0 in an AIG, so the ones that start at 1 are stored
+    complemented.
+*/
+class SokobanAig
+{
+public:
+    explicit SokobanAig(const Preprocessor &preprocessor);
+    Gia_Man_t *Build() const; // the caller owns the result; one player only
+    // replays a counter-example of Build(): lower case for walks, upper case for pushes,
+    // moves that keep the state left out; solved tells whether the last state is solved
+    string CexToMoves(const Abc_Cex_t *pCex, bool &solved) const;
+    // registers that signal correspondence (scorr, src/proof/ssw) proves constant or
+    // equivalent over all reachable states, in terms of cells; one player only
+    vector<StateInvariant> MineInvariants() const;
+
+private:
+    const Board &board;
+    int playerStart;
+    vector<int> boxStarts;
+    vector<int> regOf; // cell -> index among the walkable cells, -1 if not walkable
+};
+
+#endif // SOKOBAN_AIG_H
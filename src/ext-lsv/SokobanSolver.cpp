@@ -19,35 +19,49 @@ using namespace std;
 #include "stdint.h"
 #include "Preprocessor.h"
 
-void SokobanSolver::CnfWriter(sat_solver *pSat)
+void SokobanSolver::StreamTo(SatBackend *pSat)
 {
     // Ensure the SAT solver is aware of the maximum variable index
-    for (const auto &cl : clauses)
+    pSat->SetNumVars(layout.numVars());
+    this->backend = pSat;
+    this->sink = pSat;
+    if (clauses == &ownClauses)
+        this->clauses = nullptr;
+}
+void SokobanSolver::KeepClauses(ClauseArena *arena)
+{
+    this->clauses = arena ? arena : &ownClauses;
+    this->clauses->clear();
+}
+void SokobanSolver::CnfWriter(SatBackend *pSat)
+{
+    assert(clauses);
+    // Ensure the SAT solver is aware of the maximum variable index
+    pSat->SetNumVars(layout.numVars());
+    // clauses rejected by pSat are counted there, as when streaming
+    for (int i = 0; i < clauses->numClauses(); i++)
+        pSat->AddClause(clauses->begin(i), clauses->end(i));
+}
+void SokobanSolver::WriteDimacs(const string &fileName)
+{
+    assert(clauses);
+    ofstream outFile(fileName);
+    if (!outFile.is_open())
     {
-        lit *newClause = new lit[cl->clause.size()];
-        int i = 0;
-        for (const auto &lit : cl->clause)
-        {
-            if (lit.x < 0)
-                newClause[i] = Abc_Var2Lit(abs(lit.x), 1);
-            else
-                newClause[i] = Abc_Var2Lit(lit.x, 0);
-            i++;
-        }
-        // cout << "Adding clause: ";
-        /*for (int j = 0; j < cl->clause.size(); j++)
-        {
-            cout << newClause[j] << " ";
-        }
-        cout << endl;*/
-        if (!sat_solver_addclause(pSat, newClause, newClause + cl->clause.size()))
-            cerr << "Failed to add clause to SAT solver" << endl;
-        delete[] newClause;
+        cerr << "Error: Unable to open file " << fileName << endl;
+        return;
+    }
+    outFile << "p cnf " << layout.numVars() - 1 << " " << clauses->numClauses() << endl;
+    for (int i = 0; i < clauses->numClauses(); i++)
+    {
+        for (const int *pLit = clauses->begin(i); pLit < clauses->end(i); pLit++)
+            outFile << (Abc_LitIsCompl(*pLit) ? -Abc_Lit2Var(*pLit) : Abc_Lit2Var(*pLit)) << " ";
+        outFile << "0" << endl;
     }
-    return;
 }
 void SokobanSolver::debugger(const string &filename)
 {
+    assert(clauses);
     ofstream outFile;
     outFile.open(filename);
     if (!outFile.is_open())
@@ -56,11 +70,16 @@ void SokobanSolver::debugger(const string &filename)
         return;
     }
     cout << "Start Writing to debug file..." << endl;
-    for (const auto &cl : clauses)
+    int cell, entity, t;
+    for (int i = 0; i < clauses->numClauses(); i++)
     {
-        for (const auto &lit : cl->clause)
+        for (const int *pLit = clauses->begin(i); pLit < clauses->end(i); pLit++)
         {
-            outFile << lit.x << "(" << lit.get_x() << ", " << lit.get_y() << ", " << lit.get_p() << ", " << lit.get_t() << ") ";
+            int var = Abc_Lit2Var(*pLit);
+            outFile << (Abc_LitIsCompl(*pLit) ? -var : var);
+            if (layout.Decode(var, cell, entity, t))
+                outFile << "(" << board.coord(cell).first << ", " << board.coord(cell).second << ", " << entity << ", " << t << ")";
+            outFile << " ";
         }
         outFile << endl;
     }
@@ -68,78 +87,203 @@ void SokobanSolver::debugger(const string &filename)
     outFile << "Literals Info: " << endl;
     outFile << "Player Literals: " << endl
             << "-----------------------------" << endl;
-    for (auto it = playerLitManager.begin(); it != playerLitManager.end(); it++)
+    for (int var = 1; var < layout.numVars(); var++)
     {
-        outFile << it->second.second.x << " " << it->second.second.get_x() << " " << it->second.second.get_y() << " " << it->second.second.get_p() << " " << it->second.second.get_t() << endl;
+        if (layout.Decode(var, cell, entity, t) && layout.isPlayerEntity(entity))
+            outFile << var << " " << board.coord(cell).first << " " << board.coord(cell).second << " " << entity << " " << t << endl;
     }
     outFile << "Box Literals: " << endl
             << "-----------------------------" << endl;
-    for (auto it = boxLitManager.begin(); it != boxLitManager.end(); it++)
+    for (int var = 1; var < layout.numVars(); var++)
     {
-        outFile << it->second.second.x << " " << it->second.second.get_x() << " " << it->second.second.get_y() << " " << it->second.second.get_p() << " " << it->second.second.get_t() << endl;
+        if (layout.Decode(var, cell, entity, t) && !layout.isPlayerEntity(entity))
+            outFile << var << " " << board.coord(cell).first << " " << board.coord(cell).second << " " << entity - playerNum << " " << t << endl;
     }
     outFile << "Player initial positions: " << endl;
-    for (const auto &pos : mapInfo["Players"])
+    for (const auto &pos : mapInfo.at("Players"))
     {
         outFile << pos.first << " " << pos.second << endl;
     }
     outFile << "Box initial positions: " << endl;
-    for (const auto &pos : mapInfo["Boxes"])
+    for (const auto &pos : mapInfo.at("Boxes"))
     {
         outFile << pos.first << " " << pos.second << endl;
     }
-    outFile << "Lit Dictionary: " << endl;
-    for (auto it = LitDictionary.begin(); it != LitDictionary.end(); it++)
-    {
-        outFile << it->first << ": " << it->second.get_x() << " " << it->second.get_y() << " " << it->second.get_p() << " " << it->second.get_t() << " " << it->second.get_identity() << endl;
-    }
     outFile.close();
     cout << "Done" << endl;
     return;
 }
-void Clause::AddLit(const Lit &p)
-{
-    this->clause.push_back(p);
-}
-SokobanSolver::SokobanSolver(const Preprocessor &preprocessor) : preprocessor(preprocessor)
+SokobanSolver::SokobanSolver(const Preprocessor &preprocessor, bool occupancy) : preprocessor(preprocessor), board(preprocessor.get_board()), mapInfo(preprocessor.get_mapInfo())
 {
-    this->mapInfo = preprocessor.get_mapInfo();
+    this->clauses = &ownClauses;
+    this->sink = nullptr;
+    this->nClauses = 0;
     this->boxNum = preprocessor.boxNum;
     this->playerNum = preprocessor.playerNum;
     this->mapSize = preprocessor.mapSize;
-    this->LitIndex = 1;
+    this->occupancy = occupancy;
+    this->stepLimit = -1;
+    this->layout = VarLayout(board, playerNum, occupancy ? 1 : boxNum);
 };
 void SokobanSolver::setStepLimit(int limit)
 {
     this->stepLimit = limit;
+    layout.reserveFrames(limit);
 }
-void SokobanSolver::AddClause(Clause *newClause)
+void SokobanSolver::ExtendTo(int limit)
 {
-    this->clauses.push_back(newClause);
+    frameBegin = stepLimit + 1;
+    setStepLimit(limit);
+    AllConstraints();
+    if (idleSelectors)
+        IdleConstraints();
 }
-Lit SokobanSolver::AddPlayerLiteral(int row, int col, int player, int t)
+void SokobanSolver::IdleConstraints()
 {
-    string key = createKey(row, col, player, t);
-    if (playerLitManager.find(key) == playerLitManager.end()) // literal not instantiated yet
+    // one direction is enough: the placement constraints of frame t + 1 leave
+    // every player and box on exactly one cell
+    for (int t = FirstFrame(0, 1); t < stepLimit; t++)
     {
-        Lit newLit(row, col, player, t, LitIndex, 1);
-        playerLitManager[key] = {LitIndex, newLit};
-        LitDictionary[LitIndex] = newLit;
-        this->LitIndex++;
+        Lit idle(layout.NewAuxVar());
+        idleLits.push_back(idle);
+        for (int cell : board.walkableCells())
+        {
+            for (int player = 0; player < playerNum; player++)
+                AddClause({~idle, ~PlayerLit(cell, player, t), PlayerLit(cell, player, t + 1)});
+            for (int box = 0; box < boxNum; box++)
+                AddClause({~idle, ~BoxLit(cell, box, t), BoxLit(cell, box, t + 1)});
+        }
     }
-    return playerLitManager[key].second;
 }
-Lit SokobanSolver::AddBoxLiteral(int row, int col, int box, int t)
+Lit SokobanSolver::get_solvedByLit(int limit) const
+{
+    // latest horizon not beyond limit
+    auto it = upper_bound(solvedByLits.begin(), solvedByLits.end(), limit, [](int value, const pair<int, Lit> &latch)
+                          { return value < latch.first; });
+    assert(it != solvedByLits.begin());
+    return prev(it)->second;
+}
+void SokobanSolver::ComputeWindows(bool playerWindows)
 {
-    string key = createKey(row, col, box, t);
-    if (boxLitManager.find(key) == boxLitManager.end()) // literal not instantiated yet
+    if (frameBegin == 0)
+        pruned.assign(layout.numVars(), false);
+    else
+        pruned.resize(layout.numVars(), false); // earlier frames keep their windows
+    int nCells = board.numCells();
+    int boxSlots = occupancy ? 1 : boxNum;
+    // with as many boxes as targets every box ends on a target; the pushes left
+    // depend on the horizon, which is still open when extending incrementally,
+    // and the induction cases do not end in the goal at the last frame
+    bool toTarget = boxNum == (int)board.targetCells().size() && !incremental && induction == InductionCase::None;
+    const vector<int> &toGoal = preprocessor.getGoalDistances();
+    auto prune = [&](int var)
+    {
+        pruned[var] = true;
+        stats.prunedVars++;
+    };
+    for (int t = frameBegin; t <= stepLimit; t++)
+    {
+        for (int player = 0; player < playerNum && playerWindows; player++)
+        {
+            const vector<int> &fromStart = preprocessor.getPlayerDistances(player);
+            for (int cell = 0; cell < nCells; cell++)
+            {
+                if (fromStart[cell] == -1 || fromStart[cell] > t)
+                    prune(layout.PlayerVar(cell, player, t));
+            }
+        }
+        for (int slot = 0; slot < boxSlots; slot++)
+        {
+            for (int cell = 0; cell < nCells; cell++)
+            {
+                // pushes needed to bring a box here; in the occupancy layout any box will do
+                int pushes = -1;
+                for (int box = occupancy ? 0 : slot; box < (occupancy ? boxNum : slot + 1); box++)
+                {
+                    int d = preprocessor.getBoxDistances(box)[cell];
+                    if (d != -1 && (pushes == -1 || d < pushes))
+                        pushes = d;
+                }
+                bool late = toTarget && (toGoal[cell] == -1 || toGoal[cell] > stepLimit - t);
+                if (pushes == -1 || pushes > t || late)
+                    prune(layout.BoxVar(cell, slot, t));
+            }
+        }
+    }
+}
+vector<vector<Lit>> SokobanSolver::PlayerCubes(int nFrames) const
+{
+    vector<vector<Lit>> cubes(1);
+    for (int i = 1; i <= nFrames; i++)
     {
-        Lit newLit(row, col, box, t, LitIndex, 0);
-        boxLitManager[key] = {LitIndex, newLit};
-        LitDictionary[LitIndex] = newLit;
-        this->LitIndex++;
+        int t = stepLimit * i / (nFrames + 1);
+        vector<vector<Lit>> split;
+        for (const vector<Lit> &cube : cubes)
+        {
+            for (int cell : board.walkableCells())
+            {
+                if (Pruned(PlayerLit(cell, 0, t)))
+                    continue;
+                split.push_back(cube);
+                split.back().push_back(PlayerLit(cell, 0, t));
+            }
+        }
+        cubes.swap(split);
     }
-    return boxLitManager[key].second;
+    return cubes;
+}
+Clause &SokobanSolver::NewClause()
+{
+    scratch.lits.clear();
+    return scratch;
+}
+void SokobanSolver::AddClause(const Clause &newClause)
+{
+    const int *begin = newClause.lits.data();
+    const int *end = begin + newClause.lits.size();
+    if (!pruned.empty())
+    {
+        filtered.lits.clear();
+        for (const int *lit = begin; lit != end; lit++)
+        {
+            int var = Abc_Lit2Var(*lit);
+            if (var >= (int)pruned.size() || !pruned[var])
+                filtered.lits.push_back(*lit);
+            else if (Abc_LitIsCompl(*lit)) // satisfied by a pruned literal
+            {
+                stats.prunedClauses++;
+                return;
+            }
+        }
+        if (filtered.lits.empty())
+        {
+            nEmpty++;
+            nClauses++;
+            return;
+        }
+        begin = filtered.lits.data();
+        end = begin + filtered.lits.size();
+    }
+    if (sink)
+        sink->AddClause(begin, end);
+    if (clauses)
+        clauses->AddClause(begin, end);
+    nClauses++;
+}
+void SokobanSolver::AddClause(initializer_list<Lit> lits)
+{
+    Clause &newClause = NewClause();
+    for (const Lit &lit : lits)
+        newClause.AddLit(lit);
+    AddClause(newClause);
+}
+Lit SokobanSolver::AddPlayerLiteral(int row, int col, int player, int t)
+{
+    return PlayerLit(board.cellId(row, col), player, t);
+}
+Lit SokobanSolver::AddBoxLiteral(int row, int col, int box, int t)
+{
+    return BoxLit(board.cellId(row, col), box, t);
 }
 vector<vector<Lit>> cartesianProduct(const vector<set<Lit>> &sets)
 {
@@ -167,144 +311,178 @@ vector<vector<Lit>> cartesianProduct(const vector<set<Lit>> &sets)
 void SokobanSolver::PlayerMovementConstraints()
 {
     // cout << "Adding player movement constraints..." << endl;
-    for (int t = 0; t < stepLimit; t++)
+    for (int t = FirstFrame(0, 1); t < stepLimit; t++)
     {
         for (int player = 0; player < playerNum; player++)
         {
-            for (auto walkable_coord : mapInfo["Walkable"])
+            for (int cell : board.walkableCells())
             {
-                int row = walkable_coord.first;
-                int col = walkable_coord.second;
-                // move up
-                Clause *clause = new Clause();
-                clause->AddLit(~(AddPlayerLiteral(row, col, player, t)));
-                clause->AddLit(AddPlayerLiteral(row, col, player, t + 1));
-                if (row > 0 && preprocessor.notWall(row - 1, col)) // row-1 >= 0
-                    clause->AddLit(AddPlayerLiteral(row - 1, col, player, t + 1));
-                // move down
-                if (row < mapSize.first - 1 && preprocessor.notWall(row + 1, col))
-                    clause->AddLit(AddPlayerLiteral(row + 1, col, player, t + 1));
-                // move left
-                if (col > 0 && preprocessor.notWall(row, col - 1))
-                    clause->AddLit(AddPlayerLiteral(row, col - 1, player, t + 1));
-                // move right
-                if (col < mapSize.second - 1 && preprocessor.notWall(row, col + 1))
-                    clause->AddLit(AddPlayerLiteral(row, col + 1, player, t + 1));
+                // stay, or move up / down / left / right
+                Clause &clause = NewClause();
+                clause.AddLit(~PlayerLit(cell, player, t));
+                clause.AddLit(PlayerLit(cell, player, t + 1));
+                for (int dir = 0; dir < 4; dir++)
+                {
+                    if (board.neighbour(cell, dir) != -1)
+                        clause.AddLit(PlayerLit(board.neighbour(cell, dir), player, t + 1));
+                }
                 AddClause(clause);
             }
         }
     }
 
-    for (int t = 1; t <= stepLimit; t++)
+    for (int t = FirstFrame(1); t <= stepLimit; t++)
     {
         for (int player = 0; player < playerNum; player++)
         {
-            for (auto walkable_coord : mapInfo["Walkable"])
+            for (int cell : board.walkableCells())
             {
-                int row = walkable_coord.first;
-                int col = walkable_coord.second;
-                Clause *clause = new Clause();
-                clause->AddLit(~(AddPlayerLiteral(row, col, player, t)));
-                clause->AddLit(AddPlayerLiteral(row, col, player, t - 1));
-                if (row > 0 && preprocessor.notWall(row - 1, col))
-                    clause->AddLit(AddPlayerLiteral(row - 1, col, player, t - 1));
-                if (row < mapSize.first - 1 && preprocessor.notWall(row + 1, col))
-                    clause->AddLit(AddPlayerLiteral(row + 1, col, player, t - 1));
-                if (col > 0 && preprocessor.notWall(row, col - 1))
-                    clause->AddLit(AddPlayerLiteral(row, col - 1, player, t - 1));
-                if (col < mapSize.second - 1 && preprocessor.notWall(row, col + 1))
-                    clause->AddLit(AddPlayerLiteral(row, col + 1, player, t - 1));
+                Clause &clause = NewClause();
+                clause.AddLit(~PlayerLit(cell, player, t));
+                clause.AddLit(PlayerLit(cell, player, t - 1));
+                for (int dir = 0; dir < 4; dir++)
+                {
+                    if (board.neighbour(cell, dir) != -1)
+                        clause.AddLit(PlayerLit(board.neighbour(cell, dir), player, t - 1));
+                }
                 AddClause(clause);
             }
         }
     }
 }
 
+// order in which the push / pull origins of a box are listed
+static const int boxOriginOrder[4] = {Board::UP, Board::DOWN, Board::RIGHT, Board::LEFT};
+
 void SokobanSolver::BoxPushMovementConstraints()
 {
     // cout << "Adding box push movement constraints..." << endl;
-    for (auto walkable_coord : mapInfo["Walkable"])
+    BoxFrameAxioms(false);
+}
+
+// A box that appears on a cell must have been moved there by some player
+// from one of the four sides:
+//   B(c,t) & ~B(c,t-1) -> OR_{d,p} (B(from,t-1) & P(p before move) & P(p after move))
+// Cartesian expands the disjunction of conjunctions directly (3^(4*players)
+// clauses per cell, box and step). Auxiliary names each conjunction instead:
+// move(c,d,p,t) stands for the player part and is shared by all boxes,
+// arrive(c,b,d,t) adds the box part, which keeps the size linear.
+void SokobanSolver::BoxFrameAxioms(bool pull)
+{
+    int nClausesBefore = nClauses;
+    int nVarsBefore = layout.numVars();
+    for (int t = FirstFrame(1); t <= stepLimit; t++) // all time steps except first state t = 0
     {
-        int row = walkable_coord.first;
-        int col = walkable_coord.second;
-        if (preprocessor.isDeadLockBoxPos(row, col))
-            continue;
-        for (int box = 0; box < boxNum; box++)
+        for (int cell : board.walkableCells())
         {
-            for (int t = 1; t <= stepLimit; t++) // all time steps except first state t = 0
+            if (board.isDeadlock(cell))
+                continue;
+            // the box comes from the neighbour in dir; a pushing player moves from two squares
+            // away onto that neighbour, a pulling player moves from this cell to the opposite side
+            int from[4], before[4], after[4];
+            int nOrigins = 0;
+            for (int dir : boxOriginOrder)
             {
-                // initialize the sets to be taken cartesian products, that is, get all the variables appeared in the constraint
-                // ->
-                vector<set<Lit>> sets_push;
-                for (int player = 0; player < playerNum; player++)
+                int origin = board.neighbour(cell, dir);
+                int start = pull ? cell : board.beyond(cell, dir);
+                int end = pull ? board.neighbour(cell, Board::Opposite(dir)) : origin;
+                if (origin == -1 || start == -1 || end == -1 || board.isDeadlock(origin))
+                    continue;
+                from[nOrigins] = origin;
+                before[nOrigins] = start;
+                after[nOrigins] = end;
+                nOrigins++;
+            }
+            bool someBox = false;
+            for (int box = 0; box < boxNum; box++)
+                someBox = someBox || !Pruned(BoxLit(cell, box, t));
+            if (nOrigins == 0 || !someBox)
+                continue;
+            if (options.push == PushEncoding::Cartesian)
+            {
+                for (int box = 0; box < boxNum; box++)
                 {
-                    // Ensure there are no obstacles in the push path
-                    // push up
-                    if (row - 2 >= 0 && preprocessor.notWall(row - 1, col) && !preprocessor.isDeadLockBoxPos(row - 1, col) && preprocessor.notWall(row - 2, col))
-                    {
-                        sets_push.push_back({AddBoxLiteral(row - 1, col, box, t - 1), AddPlayerLiteral(row - 2, col, player, t - 1), AddPlayerLiteral(row - 1, col, player, t)});
-                    }
-                    if (row + 2 < mapSize.first && preprocessor.notWall(row + 1, col) && !preprocessor.isDeadLockBoxPos(row + 1, col) && preprocessor.notWall(row + 2, col))
+                    // initialize the sets to be taken cartesian products, that is, get all the variables appeared in the constraint
+                    vector<set<Lit>> sets;
+                    for (int player = 0; player < playerNum; player++)
                     {
-                        sets_push.push_back({AddBoxLiteral(row + 1, col, box, t - 1), AddPlayerLiteral(row + 2, col, player, t - 1), AddPlayerLiteral(row + 1, col, player, t)});
+                        for (int k = 0; k < nOrigins; k++)
+                            sets.push_back({BoxLit(from[k], box, t - 1), PlayerLit(before[k], player, t - 1), PlayerLit(after[k], player, t)});
                     }
-                    if (col + 2 < mapSize.second && preprocessor.notWall(row, col + 1) && !preprocessor.isDeadLockBoxPos(row, col + 1) && preprocessor.notWall(row, col + 2))
+                    // iterate through the cartesian product {{a, b}, {c, d, e}, ...}
+                    for (const auto &combination : cartesianProduct(sets))
                     {
-                        sets_push.push_back({AddBoxLiteral(row, col + 1, box, t - 1), AddPlayerLiteral(row, col + 2, player, t - 1), AddPlayerLiteral(row, col + 1, player, t)});
-                    }
-                    if (col - 2 >= 0 && preprocessor.notWall(row, col - 1) && !preprocessor.isDeadLockBoxPos(row, col - 1) && preprocessor.notWall(row, col - 2))
-                    {
-                        sets_push.push_back({AddBoxLiteral(row, col - 1, box, t - 1), AddPlayerLiteral(row, col - 2, player, t - 1), AddPlayerLiteral(row, col - 1, player, t)});
+                        Clause &newClause = NewClause();
+                        newClause.AddLit(~BoxLit(cell, box, t));
+                        newClause.AddLit(BoxLit(cell, box, t - 1));
+                        for (const auto &lit : combination)
+                            newClause.AddLit(lit);
+                        AddClause(newClause);
                     }
                 }
-                if (sets_push.empty())
+                continue;
+            }
+            // move(c,d,p,t) -> P(before,p,t-1) & P(after,p,t)
+            vector<Lit> moves(nOrigins * playerNum);
+            for (int k = 0; k < nOrigins; k++)
+            {
+                for (int player = 0; player < playerNum; player++)
+                {
+                    Lit move(layout.NewAuxVar());
+                    AddClause({~move, PlayerLit(before[k], player, t - 1)});
+                    AddClause({~move, PlayerLit(after[k], player, t)});
+                    moves[k * playerNum + player] = move;
+                }
+            }
+            for (int box = 0; box < boxNum; box++)
+            {
+                if (Pruned(BoxLit(cell, box, t)))
                     continue;
-                // execute cartesian products
-                vector<vector<Lit>> Cartesian_push = cartesianProduct(sets_push);
-
-                // iterate through the cartesian product {{a, b}, {c, d, e}, ...}
-                // some sets might be {{}} since no push backs before
-                for (const auto &set : Cartesian_push)
+                // arrive(c,b,d,t) -> B(from,b,t-1) & OR_p move(c,d,p,t)
+                Lit arrive[4];
+                for (int k = 0; k < nOrigins; k++)
                 {
-                    Clause *newClause = new Clause;
-                    newClause->AddLit(~(AddBoxLiteral(row, col, box, t)));
-                    newClause->AddLit(AddBoxLiteral(row, col, box, t - 1));
-                    if (!set.empty())
-                    {
-                        for (const auto &lit : set)
-                            newClause->AddLit(lit);
-                    }
-                    AddClause(newClause);
+                    arrive[k] = Lit(layout.NewAuxVar());
+                    AddClause({~arrive[k], BoxLit(from[k], box, t - 1)});
+                    Clause &someMove = NewClause();
+                    someMove.AddLit(~arrive[k]);
+                    for (int player = 0; player < playerNum; player++)
+                        someMove.AddLit(moves[k * playerNum + player]);
+                    AddClause(someMove);
                 }
+                Clause &newClause = NewClause();
+                newClause.AddLit(~BoxLit(cell, box, t));
+                newClause.AddLit(BoxLit(cell, box, t - 1));
+                for (int k = 0; k < nOrigins; k++)
+                    newClause.AddLit(arrive[k]);
+                AddClause(newClause);
             }
         }
     }
+    stats.frameClauses += nClauses - nClausesBefore;
+    stats.frameVars += layout.numVars() - nVarsBefore;
 }
 
 void SokobanSolver::DebugConstraints()
 {
-    for (auto walkable_coord : mapInfo["Walkable"])
+    static const int dirs[4] = {Board::DOWN, Board::UP, Board::RIGHT, Board::LEFT};
+    for (int cell : board.walkableCells())
     {
-        int row = walkable_coord.first;
-        int col = walkable_coord.second;
-        if (preprocessor.isDeadLockBoxPos(row, col))
+        if (board.isDeadlock(cell))
             continue;
         for (int box = 0; box < boxNum; box++)
         {
-            for (int t = 1; t <= stepLimit; t++)
+            for (int t = FirstFrame(1); t <= stepLimit; t++)
             {
-                vector<pair<int, int>> dir = {{1, 0}, {-1, 0}, {0, 1}, {0, -1}};
-                Clause *newClause = new Clause;
-                newClause->AddLit(~(AddBoxLiteral(row, col, box, t)));
-                newClause->AddLit(AddBoxLiteral(row, col, box, t - 1));
-                for (const auto &dir_pair : dir)
+                Clause &newClause = NewClause();
+                newClause.AddLit(~BoxLit(cell, box, t));
+                newClause.AddLit(BoxLit(cell, box, t - 1));
+                for (int dir : dirs)
                 {
-                    int row_dir = dir_pair.first;
-                    int col_dir = dir_pair.second;
-                    if (row + row_dir >= 0 && row + row_dir < mapSize.first && col + col_dir >= 0 && col + col_dir < mapSize.second && !preprocessor.isDeadLockBoxPos(row + row_dir, col + col_dir) && preprocessor.notWall(row + row_dir, col + col_dir))
-                        newClause->AddLit(AddBoxLiteral(row + row_dir, col + col_dir, box, t - 1));
+                    int next = board.neighbour(cell, dir);
+                    if (next != -1 && !board.isDeadlock(next))
+                        newClause.AddLit(BoxLit(next, box, t - 1));
                 }
-                // cout << "Adding Debug Constraint for Box " << box << " at (" << row << ", " << col << ") at time " << t << endl;
                 AddClause(newClause);
             }
         }
@@ -313,30 +491,15 @@ void SokobanSolver::DebugConstraints()
 
 void SokobanSolver::PlayerSinglePlacementConstraints()
 {
-    vector<pair<int, int>> validPositions;
-
-    // Collect all valid positions
-    for (auto walkable_coord : mapInfo["Walkable"])
-    {
-        int row = walkable_coord.first;
-        int col = walkable_coord.second;
-        validPositions.push_back({row, col});
-    }
-
+    vector<Lit> lits;
     for (int player = 0; player < playerNum; player++)
     {
-        for (int t = 0; t <= stepLimit; t++)
+        for (int t = FirstFrame(0); t <= stepLimit; t++)
         {
-            for (size_t i = 0; i < validPositions.size(); i++)
-            {
-                for (size_t j = i + 1; j < validPositions.size(); j++)
-                {
-                    Clause *newClause = new Clause;
-                    newClause->AddLit(~(AddPlayerLiteral(validPositions[i].first, validPositions[i].second, player, t)));
-                    newClause->AddLit(~(AddPlayerLiteral(validPositions[j].first, validPositions[j].second, player, t)));
-                    AddClause(newClause);
-                }
-            }
+            lits.clear();
+            for (int cell : board.walkableCells())
+                lits.push_back(PlayerLit(cell, player, t));
+            AtMostOne(lits);
         }
     }
 }
@@ -344,32 +507,24 @@ void SokobanSolver::BoxSinglePlacementConstraints()
 {
     // cout << "Adding box single placement constraints..." << endl;
 
-    vector<pair<int, int>> validPositions;
+    vector<int> validPositions;
 
     // Collect all valid positions
-    for (auto walkable_coord : mapInfo["Walkable"])
+    for (int cell : board.walkableCells())
     {
-        int row = walkable_coord.first;
-        int col = walkable_coord.second;
-        if (preprocessor.isDeadLockBoxPos(row, col))
-            continue;
-        validPositions.push_back({row, col});
+        if (!board.isDeadlock(cell))
+            validPositions.push_back(cell);
     }
 
+    vector<Lit> lits;
     for (int box = 0; box < boxNum; box++)
     {
-        for (int t = 0; t <= stepLimit; t++)
+        for (int t = FirstFrame(0); t <= stepLimit; t++)
         {
-            for (size_t i = 0; i < validPositions.size(); i++)
-            {
-                for (size_t j = i + 1; j < validPositions.size(); j++)
-                {
-                    Clause *newClause = new Clause;
-                    newClause->AddLit(~(AddBoxLiteral(validPositions[i].first, validPositions[i].second, box, t)));
-                    newClause->AddLit(~(AddBoxLiteral(validPositions[j].first, validPositions[j].second, box, t)));
-                    AddClause(newClause);
-                }
-            }
+            lits.clear();
+            for (int cell : validPositions)
+                lits.push_back(BoxLit(cell, box, t));
+            AtMostOne(lits);
         }
     }
 }
@@ -377,24 +532,17 @@ void SokobanSolver::BoxSinglePlacementConstraints()
 void SokobanSolver::BoxCollisionConstraints() // should be on different positions at all time steps
 {
     // cout << "Adding box collision constraints..." << endl;
-    for (int box1 = 0; box1 < boxNum - 1; box1++)
+    vector<Lit> lits;
+    for (int cell : board.walkableCells())
     {
-        for (int box2 = box1 + 1; box2 < boxNum; box2++)
+        if (board.isDeadlock(cell))
+            continue;
+        for (int t = FirstFrame(0); t <= stepLimit; t++)
         {
-            for (auto walkable_coord : mapInfo["Walkable"])
-            {
-                int row = walkable_coord.first;
-                int col = walkable_coord.second;
-                if (preprocessor.isDeadLockBoxPos(row, col))
-                    continue;
-                for (int t = 0; t <= stepLimit; t++)
-                {
-                    Clause *newClause = new Clause;
-                    newClause->AddLit(~(AddBoxLiteral(row, col, box1, t)));
-                    newClause->AddLit(~(AddBoxLiteral(row, col, box2, t)));
-                    AddClause(newClause);
-                }
-            }
+            lits.clear();
+            for (int box = 0; box < boxNum; box++)
+                lits.push_back(BoxLit(cell, box, t));
+            AtMostOne(lits);
         }
     }
 }
@@ -406,19 +554,12 @@ void SokobanSolver::BoxAndPlayerCollisionConstraints()
     {
         for (int box = 0; box < boxNum; box++)
         {
-            for (auto walkable_coord : mapInfo["Walkable"])
+            for (int cell : board.walkableCells())
             {
-                int row = walkable_coord.first;
-                int col = walkable_coord.second;
-                if (preprocessor.isDeadLockBoxPos(row, col))
+                if (board.isDeadlock(cell))
                     continue;
-                for (int t = 0; t <= stepLimit; t++)
-                {
-                    Clause *newClause = new Clause;
-                    newClause->AddLit(~(AddBoxLiteral(row, col, box, t)));
-                    newClause->AddLit(~(AddPlayerLiteral(row, col, player, t)));
-                    AddClause(newClause);
-                }
+                for (int t = FirstFrame(0); t <= stepLimit; t++)
+                    AddClause({~BoxLit(cell, box, t), ~PlayerLit(cell, player, t)});
             }
         }
     }
@@ -427,85 +568,37 @@ void SokobanSolver::BoxAndPlayerCollisionConstraints()
 void SokobanSolver::PlayerCollisionConstraints()
 {
     // cout << "Adding player collision constraints..." << endl;
-    for (int player1 = 0; player1 < playerNum - 1; player1++)
+    vector<Lit> lits;
+    for (int cell : board.walkableCells())
     {
-        for (int player2 = player1 + 1; player2 < playerNum; player2++)
+        for (int t = FirstFrame(1); t <= stepLimit; t++)
         {
-            for (auto walkable_coord : mapInfo["Walkable"])
-            {
-                int row = walkable_coord.first;
-                int col = walkable_coord.second;
-                for (int t = 1; t <= stepLimit; t++)
-                {
-                    Clause *newClause = new Clause;
-                    newClause->AddLit(~(AddPlayerLiteral(row, col, player1, t)));
-                    newClause->AddLit(~(AddPlayerLiteral(row, col, player2, t)));
-                    AddClause(newClause);
-                }
-            }
+            lits.clear();
+            for (int player = 0; player < playerNum; player++)
+                lits.push_back(PlayerLit(cell, player, t));
+            AtMostOne(lits);
         }
     }
 }
-void SokobanSolver::PlayerHeadOnConstraints() // vertical
+void SokobanSolver::PlayerHeadOnConstraints()
 {
     // cout << "Adding player head on constraints..." << endl;
-    for (int player1 = 0; player1 < playerNum; player1++)
-    {
-        for (int player2 = player1 + 1; player2 < playerNum; player2++)
-        {
-            for (auto walkable_coord : mapInfo["Walkable"])
-            {
-                int row = walkable_coord.first;
-                int col = walkable_coord.second;
-                for (int t = 1; t < stepLimit; t++)
-                {
-                    // consider boundary conditions
-                    if (preprocessor.notWall(row, col + 1))
-                    {
-                        Clause *newClause1 = new Clause;
-                        newClause1->AddLit(~(AddPlayerLiteral(row, col, player1, t)));
-                        newClause1->AddLit(~(AddPlayerLiteral(row, col + 1, player1, t + 1)));
-                        newClause1->AddLit(~(AddPlayerLiteral(row, col + 1, player2, t)));
-                        newClause1->AddLit(~(AddPlayerLiteral(row, col, player2, t + 1)));
-                        AddClause(newClause1);
-
-                        Clause *newClause2 = new Clause;
-                        newClause2->AddLit(~(AddPlayerLiteral(row, col, player2, t)));
-                        newClause2->AddLit(~(AddPlayerLiteral(row, col + 1, player2, t + 1)));
-                        newClause2->AddLit(~(AddPlayerLiteral(row, col + 1, player1, t)));
-                        newClause2->AddLit(~(AddPlayerLiteral(row, col, player1, t + 1)));
-                        AddClause(newClause2);
-                    }
-                }
-            }
-        }
-    }
-    for (int player1 = 0; player1 < playerNum; player1++)
+    // two players may not swap places, horizontally or vertically
+    for (int dir : {Board::RIGHT, Board::DOWN})
     {
-        for (int player2 = player1 + 1; player2 < playerNum; player2++)
+        for (int player1 = 0; player1 < playerNum; player1++)
         {
-            for (auto walkable_coord : mapInfo["Walkable"])
+            for (int player2 = player1 + 1; player2 < playerNum; player2++)
             {
-                int row = walkable_coord.first;
-                int col = walkable_coord.second;
-                for (int t = 1; t < stepLimit; t++)
+                for (int cell : board.walkableCells())
                 {
-                    if (preprocessor.notWall(row + 1, col))
+                    int next = board.neighbour(cell, dir);
+                    if (next == -1)
+                        continue;
+                    for (int t = FirstFrame(1, 1); t < stepLimit; t++)
                     {
-                        // consider boundary conditions
-                        Clause *newClause1 = new Clause;
-                        newClause1->AddLit(~(AddPlayerLiteral(row, col, player1, t)));
-                        newClause1->AddLit(~(AddPlayerLiteral(row + 1, col, player1, t + 1)));
-                        newClause1->AddLit(~(AddPlayerLiteral(row + 1, col, player2, t)));
-                        newClause1->AddLit(~(AddPlayerLiteral(row, col, player2, t + 1)));
-                        AddClause(newClause1);
-
-                        Clause *newClause2 = new Clause;
-                        newClause2->AddLit(~(AddPlayerLiteral(row, col, player2, t)));
-                        newClause2->AddLit(~(AddPlayerLiteral(row + 1, col, player2, t + 1)));
-                        newClause2->AddLit(~(AddPlayerLiteral(row + 1, col, player1, t)));
-                        newClause2->AddLit(~(AddPlayerLiteral(row, col, player1, t + 1)));
-                        AddClause(newClause2);
+                        AddClause({~PlayerLit(cell, player1, t), ~PlayerLit(next, player1, t + 1), ~PlayerLit(next, player2, t), ~PlayerLit(cell, player2, t + 1)});
+                        AddClause({~PlayerLit(cell, player2, t), ~PlayerLit(next, player2, t + 1), ~PlayerLit(next, player1, t), ~PlayerLit(cell, player1, t + 1)});
                     }
                 }
             }
@@ -515,50 +608,25 @@ void SokobanSolver::PlayerHeadOnConstraints() // vertical
 void SokobanSolver::InitState()
 {
     // cout << "Adding initial state..." << endl;
-    // can be optimized
     // at state t = 0 and for all players
     for (int player = 0; player < playerNum; player++)
     {
-        Clause *PlayerClause = new Clause();
-        int playerPos_row = mapInfo["Players"][player].first;
-        int playerPos_col = mapInfo["Players"][player].second;
-        PlayerClause->AddLit(AddPlayerLiteral(playerPos_row, playerPos_col, player, 0));
-        AddClause(PlayerClause);
-
-        for (int row = 0; row < mapSize.first; row++)
+        int start = board.cellId(mapInfo.at("Players")[player].first, mapInfo.at("Players")[player].second);
+        AddClause({PlayerLit(start, player, 0)});
+        for (int cell = 0; cell < board.numCells(); cell++)
         {
-            for (int col = 0; col < mapSize.second; col++)
-            {
-                if (!(row == playerPos_row && col == playerPos_col) && preprocessor.notWall(row, col))
-                {
-                    Clause *NotPlayerClause = new Clause();
-                    NotPlayerClause->AddLit(~(AddPlayerLiteral(row, col, player, 0)));
-                    AddClause(NotPlayerClause);
-                }
-            }
+            if (cell != start)
+                AddClause({~PlayerLit(cell, player, 0)});
         }
     }
     for (int box = 0; box < boxNum; box++)
     {
-        Clause *BoxClause = new Clause();
-        int boxPos_row = mapInfo["Boxes"][box].first;
-        int boxPos_col = mapInfo["Boxes"][box].second;
-        BoxClause->AddLit(AddBoxLiteral(boxPos_row, boxPos_col, box, 0));
-        AddClause(BoxClause);
-        // cout << box << endl;
-        for (int row = 0; row < mapSize.first; row++)
+        int start = board.cellId(mapInfo.at("Boxes")[box].first, mapInfo.at("Boxes")[box].second);
+        AddClause({BoxLit(start, box, 0)});
+        for (int cell = 0; cell < board.numCells(); cell++)
         {
-            for (int col = 0; col < mapSize.second; col++)
-            {
-                if (preprocessor.isDeadLockBoxPos(row, col))
-                    continue;
-                if (!(row == boxPos_row && col == boxPos_col) && (preprocessor.notWall(row, col)))
-                {
-                    Clause *NotBoxClause = new Clause();
-                    NotBoxClause->AddLit(~(AddBoxLiteral(row, col, box, 0)));
-                    AddClause(NotBoxClause);
-                }
-            }
+            if (cell != start && !board.isDeadlock(cell))
+                AddClause({~BoxLit(cell, box, 0)});
         }
     }
 }
@@ -566,36 +634,119 @@ void SokobanSolver::SolvedState()
 {
     // cout << "Adding solved state..." << endl;
     // box on target coordinates at t = stepLimit
-    for (const auto &target : mapInfo["Targets"])
-    { //(string) -> vector<pair<int, int>>
-        Clause *newClause = new Clause;
+    if (incremental)
+    {
+        // solvedBy(t) -> goal(t) | solvedBy(t-1), a latch that stays on once the goal was reached
+        goalLit = Lit(layout.NewAuxVar());
+        Lit solvedBy(layout.NewAuxVar());
+        if (solvedByLits.empty())
+            AddClause({~solvedBy, goalLit});
+        else
+            AddClause({~solvedBy, goalLit, solvedByLits.back().second});
+        solvedByLits.push_back(make_pair(stepLimit, solvedBy));
+    }
+    for (int target : board.targetCells())
+    {
+        Clause &newClause = NewClause();
+        if (incremental)
+            newClause.AddLit(~goalLit);
         for (int box = 0; box < boxNum; box++)
-        {
-            newClause->AddLit(AddBoxLiteral(target.first, target.second, box, stepLimit));
-        }
+            newClause.AddLit(BoxLit(target, box, stepLimit));
         AddClause(newClause);
     }
 }
 void SokobanSolver::ExistenceConstraints()
 {
     // cout << "Adding existence constraints..." << endl;
-    for (int t = 1; t <= stepLimit; t++)
+    for (int t = FirstFrame(1); t <= stepLimit; t++)
     {
         for (int box = 0; box < boxNum; box++)
         {
-            Clause *newClause = new Clause;
-            for (auto walkable_coord : mapInfo["Walkable"])
+            Clause &newClause = NewClause();
+            for (int cell : board.walkableCells())
             {
-                int row = walkable_coord.first;
-                int col = walkable_coord.second;
-                if (preprocessor.isDeadLockBoxPos(row, col))
-                    continue;
-                newClause->AddLit(AddBoxLiteral(row, col, box, t));
+                if (!board.isDeadlock(cell))
+                    newClause.AddLit(BoxLit(cell, box, t));
             }
             AddClause(newClause);
         }
     }
 }
+void SokobanSolver::InvariantConstraints()
+{
+    if (!options.invariants || playerNum != 1)
+        return;
+    // a signal is the disjunction of its literals, no box ever stands on a dead square
+    vector<Lit> lits, otherLits;
+    auto signal = [&](int cell, bool box, int t, vector<Lit> &out)
+    {
+        out.clear();
+        if (!box)
+            out.push_back(PlayerLit(cell, 0, t));
+        for (int b = 0; box && b < boxNum && !board.isDeadlock(cell); b++)
+            out.push_back(BoxLit(cell, b, t));
+    };
+    // (OR a == va) -> (OR b == vb)
+    auto implication = [&](const vector<Lit> &a, bool va, const vector<Lit> &b, bool vb)
+    {
+        if (va && vb)
+        {
+            for (const Lit &la : a)
+            {
+                Clause &clause = NewClause();
+                clause.AddLit(~la);
+                for (const Lit &lb : b)
+                    clause.AddLit(lb);
+                AddClause(clause);
+            }
+        }
+        else if (va)
+        {
+            for (const Lit &la : a)
+            {
+                for (const Lit &lb : b)
+                    AddClause({~la, ~lb});
+            }
+        }
+        else if (vb)
+        {
+            Clause &clause = NewClause();
+            for (const Lit &la : a)
+                clause.AddLit(la);
+            for (const Lit &lb : b)
+                clause.AddLit(lb);
+            AddClause(clause);
+        }
+        else
+        {
+            for (const Lit &lb : b)
+            {
+                Clause &clause = NewClause();
+                for (const Lit &la : a)
+                    clause.AddLit(la);
+                clause.AddLit(~lb);
+                AddClause(clause);
+            }
+        }
+    };
+    for (int t = FirstFrame(0); t <= stepLimit; t++)
+    {
+        for (const StateInvariant &inv : *options.invariants)
+        {
+            signal(inv.cell, inv.box, t, lits);
+            if (inv.otherCell == -1)
+            {
+                // the constant as an implication from an empty, false signal
+                otherLits.clear();
+                implication(otherLits, false, lits, inv.value);
+                continue;
+            }
+            signal(inv.otherCell, inv.otherBox, t, otherLits);
+            implication(lits, true, otherLits, inv.value);
+            implication(lits, false, otherLits, !inv.value);
+        }
+    }
+}
 void SokobanSolver::tunnelMacro()
 {
     // player only
@@ -608,24 +759,24 @@ void SokobanSolver::tunnelMacro()
         if (tunnel[1].first == tunnel[0].first)
         { // horizontal tunnel, same row
             int tunnel_length = tunnel[0].second - tunnel[1].second + 1;
-            // 2 entries, opposite directions
-            for (int t = 1; t <= stepLimit; t++)
+            // 2 entries, opposite directions; t + 1 has to stay inside the horizon
+            for (int t = FirstFrame(1, 1); t < stepLimit; t++)
             {
                 // note: Tunnel: (1, 5) (1, 3) tunnel stored this way
 
                 for (int curr = 0; curr < tunnel_length; curr++)
                 {
                     // enter from left
-                    Clause *newClause1 = new Clause;
-                    newClause1->AddLit(~(AddPlayerLiteral(tunnel[0].first, tunnel[1].second + curr - 1, 0, t - 1)));
-                    newClause1->AddLit(~(AddPlayerLiteral(tunnel[0].first, tunnel[1].second + curr, 0, t)));
-                    newClause1->AddLit(AddPlayerLiteral(tunnel[0].first, tunnel[1].second + curr + 1, 0, t + 1));
+                    Clause &newClause1 = NewClause();
+                    newClause1.AddLit(~(AddPlayerLiteral(tunnel[0].first, tunnel[1].second + curr - 1, 0, t - 1)));
+                    newClause1.AddLit(~(AddPlayerLiteral(tunnel[0].first, tunnel[1].second + curr, 0, t)));
+                    newClause1.AddLit(AddPlayerLiteral(tunnel[0].first, tunnel[1].second + curr + 1, 0, t + 1));
                     AddClause(newClause1);
                     // enter from right
-                    Clause *newClause2 = new Clause;
-                    newClause2->AddLit(~(AddPlayerLiteral(tunnel[0].first, tunnel[0].second - curr + 1, 0, t - 1)));
-                    newClause2->AddLit(~(AddPlayerLiteral(tunnel[0].first, tunnel[0].second - curr, 0, t)));
-                    newClause2->AddLit(AddPlayerLiteral(tunnel[0].first, tunnel[0].second - curr - 1, 0, t + 1));
+                    Clause &newClause2 = NewClause();
+                    newClause2.AddLit(~(AddPlayerLiteral(tunnel[0].first, tunnel[0].second - curr + 1, 0, t - 1)));
+                    newClause2.AddLit(~(AddPlayerLiteral(tunnel[0].first, tunnel[0].second - curr, 0, t)));
+                    newClause2.AddLit(AddPlayerLiteral(tunnel[0].first, tunnel[0].second - curr - 1, 0, t + 1));
                     AddClause(newClause2);
                 }
             }
@@ -633,22 +784,22 @@ void SokobanSolver::tunnelMacro()
         if (tunnel[1].second == tunnel[0].second) // vertical tunnel, same column
         {
             int tunnel_length = tunnel[0].second - tunnel[1].second + 1;
-            for (int t = 1; t <= stepLimit; t++)
+            for (int t = FirstFrame(1, 1); t < stepLimit; t++)
             {
                 // enter from above
                 for (int curr = 0; curr < tunnel_length; curr++)
                 {
                     // enter from top
-                    Clause *newClause1 = new Clause;
-                    newClause1->AddLit(~(AddPlayerLiteral(tunnel[1].first + curr - 1, tunnel[0].second, 0, t - 1)));
-                    newClause1->AddLit(~(AddPlayerLiteral(tunnel[1].first + curr, tunnel[0].second, 0, t)));
-                    newClause1->AddLit(AddPlayerLiteral(tunnel[1].first + curr + 1, tunnel[0].second, 0, t + 1));
+                    Clause &newClause1 = NewClause();
+                    newClause1.AddLit(~(AddPlayerLiteral(tunnel[1].first + curr - 1, tunnel[0].second, 0, t - 1)));
+                    newClause1.AddLit(~(AddPlayerLiteral(tunnel[1].first + curr, tunnel[0].second, 0, t)));
+                    newClause1.AddLit(AddPlayerLiteral(tunnel[1].first + curr + 1, tunnel[0].second, 0, t + 1));
                     AddClause(newClause1);
                     // enter from bottom
-                    Clause *newClause2 = new Clause;
-                    newClause2->AddLit(~(AddPlayerLiteral(tunnel[0].first - curr + 1, tunnel[0].second, 0, t - 1)));
-                    newClause2->AddLit(~(AddPlayerLiteral(tunnel[0].first - curr, tunnel[0].second, 0, t)));
-                    newClause2->AddLit(AddPlayerLiteral(tunnel[0].first - curr - 1, tunnel[0].second, 0, t + 1));
+                    Clause &newClause2 = NewClause();
+                    newClause2.AddLit(~(AddPlayerLiteral(tunnel[0].first - curr + 1, tunnel[0].second, 0, t - 1)));
+                    newClause2.AddLit(~(AddPlayerLiteral(tunnel[0].first - curr, tunnel[0].second, 0, t)));
+                    newClause2.AddLit(AddPlayerLiteral(tunnel[0].first - curr - 1, tunnel[0].second, 0, t + 1));
                     AddClause(newClause2);
                 }
             }
@@ -661,11 +812,11 @@ void SokobanSolver::InitState_PulledFromTargets() // all targets occupied by a b
 {
     cout << "Adding initial state for pull stage..." << endl;
     // 1. Force each target to be occupied by *some* box
-    for (const auto &[row, col] : mapInfo["Targets"])
+    for (int target : board.targetCells())
     {
-        Clause *someBoxOnTarget = new Clause();
+        Clause &someBoxOnTarget = NewClause();
         for (int box = 0; box < boxNum; box++)
-            someBoxOnTarget->AddLit(AddBoxLiteral(row, col, box, 0));
+            someBoxOnTarget.AddLit(BoxLit(target, box, 0));
         AddClause(someBoxOnTarget);
     }
 
@@ -674,93 +825,33 @@ void SokobanSolver::InitState_PulledFromTargets() // all targets occupied by a b
     {
         for (int box2 = box1 + 1; box2 < boxNum; box2++)
         {
-            for (const auto &[row, col] : mapInfo["Targets"])
-            {
-                Clause *noTwoBoxesSameTarget = new Clause();
-                noTwoBoxesSameTarget->AddLit(~AddBoxLiteral(row, col, box1, 0));
-                noTwoBoxesSameTarget->AddLit(~AddBoxLiteral(row, col, box2, 0));
-                AddClause(noTwoBoxesSameTarget);
-            }
+            for (int target : board.targetCells())
+                AddClause({~BoxLit(target, box1, 0), ~BoxLit(target, box2, 0)});
         }
     }
 
     // find possible player starting positions
-    for (auto [r, c] : mapInfo["Targets"])
+    for (int target : board.targetCells())
     {
-        for (auto [dr, dc] : vector<pair<int, int>>{{-1, 0}, {1, 0}, {0, -1}, {0, 1}})
+        for (int dir = 0; dir < 4; dir++)
         {
-            if (preprocessor.notWall(r + dr, c + dc) && !preprocessor.isTarget(r + dr, c + dc))
-                goodPlayerStarts.push_back({r + dr, c + dc});
+            int next = board.neighbour(target, dir);
+            if (next != -1 && !board.isTarget(next))
+                goodPlayerStarts.push_back(next);
         }
     }
 
     // 3. one of the good player start positions is occupied by player
     cout << "Adding player initial position constraints..." << endl;
-    Clause *playerClause = new Clause();
-    for (const auto &[row, col] : goodPlayerStarts)
-        playerClause->AddLit(AddPlayerLiteral(row, col, 0, 0));
+    Clause &playerClause = NewClause();
+    for (int cell : goodPlayerStarts)
+        playerClause.AddLit(PlayerLit(cell, 0, 0));
     AddClause(playerClause);
 }
 void SokobanSolver::PlayerPullConstraints()
 {
     cout << "Adding player pull constraints..." << endl;
-    for (auto walkable_coord : mapInfo["Walkable"])
-    {
-        int row = walkable_coord.first;
-        int col = walkable_coord.second;
-        if (preprocessor.isDeadLockBoxPos(row, col))
-            continue;
-        for (int box = 0; box < boxNum; box++)
-        {
-            for (int t = 1; t <= stepLimit; t++) // all time steps except first state t = 0
-            {
-                // initialize the sets to be taken cartesian products, that is, get all the variables appeared in the constraint
-                vector<set<Lit>> sets_pull;
-                for (int player = 0; player < playerNum; player++)
-                {
-                    // pull down
-                    if (row - 1 >= 0 && preprocessor.notWall(row - 1, col) && !preprocessor.isDeadLockBoxPos(row - 1, col) && preprocessor.notWall(row + 1, col))
-                    {
-                        sets_pull.push_back({AddBoxLiteral(row - 1, col, box, t - 1), AddPlayerLiteral(row, col, player, t - 1), AddPlayerLiteral(row + 1, col, player, t)});
-                    }
-                    // pull up
-                    if (row + 1 < mapSize.first && preprocessor.notWall(row + 1, col) && !preprocessor.isDeadLockBoxPos(row + 1, col) && preprocessor.notWall(row - 1, col))
-                    {
-                        sets_pull.push_back({AddBoxLiteral(row + 1, col, box, t - 1), AddPlayerLiteral(row, col, player, t - 1), AddPlayerLiteral(row - 1, col, player, t)});
-                    }
-                    // pull left
-                    if (col + 1 < mapSize.second && preprocessor.notWall(row, col + 1) && !preprocessor.isDeadLockBoxPos(row, col + 1) && preprocessor.notWall(row, col - 1))
-                    {
-                        sets_pull.push_back({AddBoxLiteral(row, col + 1, box, t - 1), AddPlayerLiteral(row, col, player, t - 1), AddPlayerLiteral(row, col - 1, player, t)});
-                    }
-                    // pull right
-                    if (col - 1 >= 0 && preprocessor.notWall(row, col - 1) && !preprocessor.isDeadLockBoxPos(row, col - 1) && preprocessor.notWall(row, col + 1))
-                    {
-                        sets_pull.push_back({AddBoxLiteral(row, col - 1, box, t - 1), AddPlayerLiteral(row, col, player, t - 1), AddPlayerLiteral(row, col + 1, player, t)});
-                    }
-                }
-                if (sets_pull.empty())
-                    continue;
-                // execute cartesian products
-                vector<vector<Lit>> Cartesian_pull = cartesianProduct(sets_pull);
-
-                // iterate through the cartesian product {{a, b}, {c, d, e}, ...}
-                // some sets might be {{}} since no push backs before
-                for (const auto &set : Cartesian_pull)
-                {
-                    Clause *newClause = new Clause;
-                    newClause->AddLit(~(AddBoxLiteral(row, col, box, t)));
-                    newClause->AddLit(AddBoxLiteral(row, col, box, t - 1));
-                    if (!set.empty())
-                    {
-                        for (const auto &lit : set)
-                            newClause->AddLit(lit);
-                    }
-                    AddClause(newClause);
-                }
-            }
-        }
-    }
+    BoxFrameAxioms(true);
 }
 
 void SokobanSolver::PullStageTarget()
@@ -771,35 +862,39 @@ void SokobanSolver::PullStageTarget()
     {
         for (int box = 0; box < boxNum; box++)
         {
-            Clause *newClause = new Clause();
-            newClause->AddLit(~AddBoxLiteral(row, col, box, stepLimit));
+            Clause &newClause = NewClause();
+            newClause.AddLit(~AddBoxLiteral(row, col, box, stepLimit));
             AddClause(newClause);
         }
     }*/
 
-    for (const auto &[row, col] : mapInfo["Targets"])
+    for (int target : board.targetCells())
     {
         for (int box = 0; box < boxNum; box++)
-        {
-            Clause *newClause = new Clause();
-            newClause->AddLit(~AddBoxLiteral(row, col, box, 0));
-            newClause->AddLit(~AddBoxLiteral(row, col, box, stepLimit));
-            AddClause(newClause);
-        }
+            AddClause({~BoxLit(target, box, 0), ~BoxLit(target, box, stepLimit)});
     }
     for (int box = 0; box < boxNum; box++)
     {
-        Clause *newClause = new Clause();
+        Clause &newClause = NewClause();
         for (const auto &[row, col] : preprocessor.pullable_set)
-            newClause->AddLit(AddBoxLiteral(row, col, box, stepLimit));
+            newClause.AddLit(AddBoxLiteral(row, col, box, stepLimit));
         AddClause(newClause);
     }
 }
 
 void SokobanSolver::AllConstraints()
 {
-    InitState();
-    SolvedState();
+    // the windows count moves from the initial state, which the step case does not have
+    if (options.windows && induction != InductionCase::Step)
+        ComputeWindows(true);
+    if (frameBegin == 0 && induction == InductionCase::Step)
+        FreeInitState();
+    else if (frameBegin == 0)
+        InitState();
+    if (induction != InductionCase::Forward)
+        SolvedState();
+    if (induction != InductionCase::None)
+        UnsolvedStates(induction == InductionCase::Step ? stepLimit - 1 : stepLimit);
     // TunnelIdentifying();
     PlayerMovementConstraints();
     BoxPushMovementConstraints();
@@ -812,6 +907,7 @@ void SokobanSolver::AllConstraints()
     ExistenceConstraints();
     DebugConstraints();
     tunnelMacro();
+    InvariantConstraints();
 }
 void SokobanSolver::PullOnlyConstraints()
 {
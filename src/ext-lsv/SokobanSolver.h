@@ -14,39 +14,30 @@ using namespace std;
 #include "sat/cnf/cnf.h"
 #include "stdint.h"
 #include "Preprocessor.h"
+#include "VarLayout.h"
+#include "ClauseArena.h"
+#include "SatBackend.h"
+#include "AtMostOne.h"
 
 class Lit
 {
 public:
     friend Lit operator~(const Lit &p);
-    int x; // variable index number
+    int x; // variable index, negative when complemented
     Lit() {}
-    Lit(int row, int col, int obj, int time, int LitIndex, int identity) : coord_x(row), coord_y(col), p(obj), t(time), x(LitIndex), identity(identity) {}
-    Lit(const Lit &other) : coord_x(other.get_x()), coord_y(other.get_y()), p(other.get_p()), t(other.get_t()), x(other.x) {} // copy constructor
+    explicit Lit(int LitIndex) : x(LitIndex) {}
     // operator overloads
     bool operator==(const Lit &other) const { return this->x == other.x; }
     bool operator>(const Lit &other) const { return this->x > other.x; }
     bool operator<(const Lit &other) const { return this->x < other.x; }
 
-    int get_x() const { return coord_x; }
-    int get_y() const { return coord_y; }
-    int get_p() const { return p; }
-    int get_t() const { return t; }
-    int get_identity() const { return identity; }
-
-private:
-    int coord_x;
-    int coord_y;
-    int p;
-    int t;
-    int identity; // 1 for player, 0 for box
+    int var() const { return x < 0 ? -x : x; }
+    int toAbc() const { return x < 0 ? 2 * (-x) + 1 : 2 * x; } // same as Abc_Var2Lit(var(), x < 0)
 };
 
 inline Lit operator~(const Lit &p)
 {
-    Lit q = Lit(p);
-    q.x = q.x * (-1); // 34 -> -34
-    return q;
+    return Lit(-p.x); // 34 -> -34
 }
 class LitHash
 {
@@ -58,16 +49,84 @@ public:
 class Clause
 {
 public:
-    void AddLit(const Lit &p);
-    vector<Lit> clause;
+    void AddLit(const Lit &p) { lits.push_back(p.toAbc()); }
+    vector<int> lits; // ABC literal encoding, capacity is reused between clauses
+};
+
+// which instance of k-induction AllConstraints() encodes
+enum class InductionCase
+{
+    None,   // BMC: from the initial state to the goal at the last frame
+    Step,   // from any state, the goal at the last frame and at no earlier one
+    Forward // from the initial state, the goal at no frame
+};
+
+// how the "a box only moves when a player pushes it" frame axioms are written
+enum class PushEncoding
+{
+    Auxiliary, // one auxiliary variable per push, linear size
+    Cartesian  // expand the disjunction of pushes, exponential in the number of players
+};
+
+// A fact about every reachable state, mined on the sequential AIG of the level
+// (SokobanAig::MineInvariants()). A signal is "the player is on cell" or "a box
+// is on cell". With otherCell == -1 the signal always has value; otherwise it
+// equals the other signal when value is true, and its complement when false.
+struct StateInvariant
+{
+    int cell;
+    bool box;
+    int otherCell = -1;
+    bool otherBox = false;
+    bool value = false;
+};
+
+// encoding choices, set from the sokoban command line
+struct EncodingOptions
+{
+    AmoEncoding amo = AmoEncoding::Auto;
+    PushEncoding push = PushEncoding::Auxiliary;
+    bool windows = true; // drop literals outside the BFS distance windows, see ComputeWindows()
+    const vector<StateInvariant> *invariants = nullptr; // added to every frame, see InvariantConstraints()
+};
+
+// size of the generated CNF
+struct EncodingStats
+{
+    int amoClauses = 0;    // clauses produced by AtMostOne()
+    int amoVars = 0;       // auxiliary variables introduced by AtMostOne()
+    int frameClauses = 0;  // clauses produced by BoxFrameAxioms()
+    int frameVars = 0;     // auxiliary variables introduced by BoxFrameAxioms()
+    int prunedVars = 0;    // state variables outside the distance windows
+    int prunedClauses = 0; // clauses satisfied by a pruned literal, never emitted
 };
-// user defined hash function is necessary
 
 class SokobanSolver
 {
 public:
-    SokobanSolver(const Preprocessor &preprocessor);
+    SokobanSolver(const Preprocessor &preprocessor, bool occupancy = false); // occupancy: one box slot, see OccupancyConstraints()
     void setStepLimit(int limit);
+    int get_stepLimit() const { return stepLimit; }
+    /*
+    ============ Incremental unrolling ============
+    */
+    // AllConstraints() only for the frames after the previous horizon; the goal of every
+    // horizon is guarded by its own activation literal, to be passed as an assumption,
+    // and a monotone latch per frame says that the goal was reached at or before it
+    void setIncremental() { incremental = true; }
+    void ExtendTo(int limit);
+    Lit get_goalLit() const { return goalLit; }         // the goal holds at the last frame
+    Lit get_solvedByLit(int limit) const;               // the goal holds at some horizon <= limit
+    // Optional idle selectors: assuming get_idleLit(t) keeps every player and box in place from
+    // frame t to t + 1. A plan of k moves that starts after j idle frames reaches the goal at
+    // frame j + k, which lets a final conflict over the idle literals refute shorter horizons.
+    void setIdleSelectors() { idleSelectors = true; }
+    Lit get_idleLit(int t) const { return idleLits[t]; }
+    void IdleConstraints(); // run by ExtendTo()
+    int FirstFrame(int first, int lead = 0) const { return max(first, frameBegin - lead); } // lead: frames a clause reaches past t
+    void setOptions(const EncodingOptions &options) { this->options = options; }
+    const EncodingStats &get_stats() const { return stats; }
+    int numVars() const { return layout.numVars() - 1; }
 
     /*
     ============ Constraints ============
@@ -84,28 +143,97 @@ public:
     void ObstacleConstraints();              // 10
     void DebugConstraints();                 // 11
     void tunnelMacro();                      // 12
+    void InvariantConstraints();             // options.invariants at every frame, one player only
     void InitState();                        // 13
     void SolvedState();                      // 14
     void AllConstraints();
 
     //========== Pulling =============
-    void PlayerPullConstraints(); // 15
+    void PlayerPullConstraints();   // 15
+    void BoxFrameAxioms(bool pull); // shared by 2 and 15, uses options.push
     void InitState_PulledFromTargets();
     void PullOnlyConstraints();
     void PullStageTarget(); // requires all boxes NOT on target
     /*
+    ============ Distance windows ============
+    */
+    // A player literal is pruned when the player cannot walk to the cell in t moves, a box
+    // literal when the box cannot be pushed there in t pushes or, if every box has to end on
+    // a target, cannot reach one in the pushes left. Pruned literals are false: AddClause()
+    // drops them from clauses and drops the clauses they satisfy.
+    void ComputeWindows(bool playerWindows); // playerWindows: frames are player moves
+    bool Pruned(const Lit &lit) const { return lit.var() < (int)pruned.size() && pruned[lit.var()]; }
+    /*
+    ============ Cube-and-conquer ============
+    */
+    // Splits the horizon by the cells of player 0 at nFrames evenly spaced frames. The player
+    // walks from the start and stands on one cell per frame, so every model satisfies
+    // exactly one cube and the cubes can be solved independently under assumptions.
+    vector<vector<Lit>> PlayerCubes(int nFrames) const;
+    /*
+    ============ Actions (operator encoding) ============
+    */
+    void ActionConstraints(); // replaces AllConstraints()
+    void ActionVariables();
+    void ActionPreconditionsAndEffects();
+    void ActionFrameAxioms();
+    bool HasMove(int cell, int dir) const { return actionVars[cell * 8 + dir] != 0; } // same cells at every step
+    bool HasPush(int cell, int dir) const { return actionVars[cell * 8 + 4 + dir] != 0; }
+    Lit MoveLit(int cell, int player, int dir, int time) const { return Lit(actionVars[((time * playerNum + player) * board.numCells() + cell) * 8 + dir]); }
+    Lit PushLit(int cell, int player, int dir, int time) const { return Lit(actionVars[((time * playerNum + player) * board.numCells() + cell) * 8 + 4 + dir]); }
+    /*
+    ============ Occupancy (box-identity-free encoding) ============
+    */
+    void OccupancyConstraints(); // replaces AllConstraints(), needs the occupancy layout
+    void OccupancyInitState();
+    void OccupancySolvedState();
+    void OccupancyPushConstraints();
+    void OccupancyFrameAxioms();
+    Lit OccupancyLit(int cell, int time) const { return BoxLit(cell, 0, time); }
+    /*
+    ============ Push-level macro encoding ============
+    */
+    void MacroConstraints();                   // replaces AllConstraints(), needs the occupancy layout and one player
+    string MacroMoves(const SatBackend &sat) const; // LURD move string of a model, walks rebuilt with BFS
+    /*
+    ============ k-induction ============
+    */
+    // Changes what AllConstraints() adds at the first and the last frames, see InductionCase.
+    // Simple paths are enforced lazily: DistinctStates() for the frames EqualStates() reports.
+    void setInductionCase(InductionCase induction) { this->induction = induction; }
+    void FreeInitState();               // every player and box on some cell, replaces InitState()
+    void UnsolvedStates(int lastFrame); // the goal does not hold at frames 0 .. lastFrame
+    vector<pair<int, int>> EqualStates(const SatBackend &sat) const; // frames i < j with the same state in the model
+    void DistinctStates(int i, int j);
+    /*
+    ============ At-most-one ============
+    */
+    void AtMostOne(const vector<Lit> &lits); // uses options.amo
+    void AmoPairwise(const vector<Lit> &lits);
+    void AmoSequential(const vector<Lit> &lits);
+    void AmoCommander(const vector<Lit> &lits);
+    void AmoProduct(const vector<Lit> &lits);
+    void AmoBimander(const vector<Lit> &lits);
+    /*
     ============ Literals ============
     */
     Lit AddPlayerLiteral(int row, int col, int player, int time);
     Lit AddBoxLiteral(int row, int col, int box, int time);
-    string createKey(int x, int y, int player, int time) { return to_string(x) + "_" + to_string(y) + "_" + to_string(player) + "_" + to_string(time); }
-    Lit &get_LitDictionary(int index) { return LitDictionary[index]; }
-    unordered_map<int, Lit> get_LitDictionary() { return LitDictionary; }
+    Lit PlayerLit(int cell, int player, int time) const { return Lit(layout.PlayerVar(cell, player, time)); }
+    Lit BoxLit(int cell, int box, int time) const { return Lit(layout.BoxVar(cell, box, time)); }
+    const VarLayout &get_layout() const { return layout; }
     /*
     ============ Clauses ============
     */
-    void CnfWriter(sat_solver *pSat);
-    void AddClause(Clause *newClause);
+    void StreamTo(SatBackend *pSat);                // generators write straight into pSat instead of storing
+    void KeepClauses(ClauseArena *arena = nullptr); // also record clauses, for debugger() and WriteDimacs()
+    void CnfWriter(SatBackend *pSat);               // replay the recorded clauses
+    void WriteDimacs(const string &fileName);
+    Clause &NewClause(); // scratch clause, valid until the next NewClause()
+    void AddClause(const Clause &newClause);
+    void AddClause(initializer_list<Lit> lits);
+    int numClauses() const { return nClauses; }
+    int numFailedClauses() const { return (backend ? backend->numFailed() : 0) + nEmpty; } // > 0: the streamed instance is UNSAT
 
     /*
     ============ Debugging tool ============
@@ -114,19 +242,36 @@ public:
     void debugger(const string &fileName);
 
 private:
-    vector<pair<int, int>> goodPlayerStarts;
+    vector<int> goodPlayerStarts;
     string mapName;
-    Preprocessor preprocessor;
+    const Preprocessor &preprocessor;
+    const Board &board;
     int stepLimit;
-    int LitIndex;                                          // initialize as 1
-    unordered_map<string, vector<pair<int, int>>> mapInfo; // player, wall, block, target coordinate pairs
-    vector<Clause *> clauses;
+    const unordered_map<string, vector<pair<int, int>>> &mapInfo; // player, wall, block, target coordinate pairs
+    ClauseArena ownClauses;
+    ClauseArena *clauses; // recorded clauses, nullptr when only streaming
+    SatBackend *backend = nullptr; // set by StreamTo(), not owned
+    ClauseSink *sink; // streaming destination, nullptr when only recording
+    Clause scratch;   // reused by NewClause()
+    Clause filtered;  // scratch with the pruned literals removed
+    int nClauses;
+    int nEmpty = 0;            // clauses emptied by pruning
+    vector<bool> pruned;       // per variable, see ComputeWindows()
+    bool occupancy;            // one box slot for all boxes
+    bool incremental = false;  // see ExtendTo()
+    int frameBegin = 0;        // first frame the generators still have to cover
+    Lit goalLit;               // activation literal of SolvedState() when incremental
+    vector<pair<int, Lit>> solvedByLits; // (horizon, latch) for every ExtendTo()
+    bool idleSelectors = false;          // see IdleConstraints()
+    vector<Lit> idleLits;                // per frame t < stepLimit
+    InductionCase induction = InductionCase::None;
     pair<int, int> mapSize;
-    unordered_map<string, pair<int, Lit>> playerLitManager; // (x,y, player, time) -> litIndex
-    unordered_map<string, pair<int, Lit>> boxLitManager;    // (x,y, box, time) -> litIndex
-    unordered_map<int, Lit> LitDictionary;
+    VarLayout layout;       // (cell, player/box, time) -> variable index
+    vector<int> actionVars; // ((time * playerNum + player) * nCells + cell) * 8 + (push ? 4 : 0) + dir -> variable, 0 if none
     int playerNum;
     int boxNum;
+    EncodingOptions options;
+    EncodingStats stats;
     ofstream outFile;
 };
 
@@ -0,0 +1,35 @@
+#include "VarLayout.h"
+#include "Board.h"
+#include <algorithm>
+using namespace std;
+
+VarLayout::VarLayout(const Board &board, int playerNum, int boxNum) : playerNum(playerNum), boxNum(boxNum)
+{
+    nCells = board.numCells();
+    frameSize = (playerNum + boxNum) * nCells;
+}
+
+void VarLayout::reserveFrames(int lastFrame)
+{
+    while ((int)frameBase.size() <= lastFrame)
+    {
+        frameBase.push_back(nextVar);
+        nextVar += frameSize;
+    }
+}
+
+bool VarLayout::Decode(int var, int &cell, int &entity, int &t) const
+{
+    if (frameSize == 0 || var < 1 || var >= nextVar)
+        return false;
+    auto it = upper_bound(frameBase.begin(), frameBase.end(), var);
+    if (it == frameBase.begin())
+        return false;
+    t = (it - frameBase.begin()) - 1;
+    int offset = var - frameBase[t];
+    if (offset >= frameSize) // auxiliary variable allocated after this frame
+        return false;
+    entity = offset / nCells;
+    cell = offset % nCells;
+    return true;
+}
@@ -0,0 +1,55 @@
+#ifndef VAR_LAYOUT_H
+#define VAR_LAYOUT_H
+
+#include <vector>
+#include <cassert>
+
+using namespace std;
+
+class Board;
+
+/*
+    Dense SAT variable allocator for the state-based encoding.
+    Frame t owns one contiguous block of (playerNum + boxNum) * numCells
+    variables over the board's cell ids, so the variable of (cell, entity, t)
+    is pure arithmetic. Entities [0, playerNum) are players, the rest are
+    boxes. Auxiliary variables are handed out between frames.
+*/
+class VarLayout
+{
+public:
+    VarLayout() {}
+    VarLayout(const Board &board, int playerNum, int boxNum);
+    void reserveFrames(int lastFrame); // make frames [0, lastFrame] addressable
+
+    inline int numCells() const { return nCells; }
+
+    /*
+    ============ Variables ============
+    */
+    inline int PlayerVar(int cell, int player, int t) const
+    {
+        assert(cell >= 0 && t < (int)frameBase.size());
+        return frameBase[t] + player * nCells + cell;
+    }
+    inline int BoxVar(int cell, int box, int t) const
+    {
+        assert(cell >= 0 && t < (int)frameBase.size());
+        return frameBase[t] + (playerNum + box) * nCells + cell;
+    }
+    inline int NewAuxVar() { return nextVar++; }
+    inline int numVars() const { return nextVar; } // variable 0 is never used
+    inline int numFrames() const { return frameBase.size(); }
+    bool Decode(int var, int &cell, int &entity, int &t) const; // false for auxiliary variables
+    inline bool isPlayerEntity(int entity) const { return entity < playerNum; }
+
+private:
+    int nCells = 0;
+    int playerNum = 0;
+    int boxNum = 0;
+    int frameSize = 0;
+    int nextVar = 1;
+    vector<int> frameBase; // first variable of every frame
+};
+
+#endif // VAR_LAYOUT_H
@@ -4,6 +4,7 @@
 #include "aig/aig/aig.h"
 #include "iostream"
 #include "set"
+#include <map>
 #include "queue"
 #include "algorithm"
 #include "sat/cnf/cnf.h"
@@ -13,18 +14,30 @@
 #include <unordered_set>
 #include <thread> // For sleep
 #include <chrono> // For time delays
+#include <atomic>
+#include <mutex>
+#include <memory>
+#include <climits>
 #include "SokobanSolver.h"
 #include "Preprocessor.h"
+#include "SokobanAig.h"
+#include "FrameCnf.h"
+#include "aig/gia/giaAig.h"
+#include "proof/pdr/pdr.h"
+#include "proof/int/int.h"
 #include <fstream>
+#include <sstream>
 #include <iomanip>
 using namespace std;
 
-void visualizeSolution(Preprocessor &preprocessor, SokobanSolver &Solver, sat_solver *pSat, int step, bool verbose);
+void visualizeSolution(Preprocessor &preprocessor, SokobanSolver &Solver, SatBackend *pSat, int step, bool verbose, int firstFrame = 0);
 static int Sokoban_CommandSolve(Abc_Frame_t *pAbc, int argc, char **argv); // command function
+static int Sokoban_CommandAig(Abc_Frame_t *pAbc, int argc, char **argv);
 
 void init(Abc_Frame_t *pAbc)
 {
     Cmd_CommandAdd(pAbc, "LSV", "sokoban", Sokoban_CommandSolve, 0);
+    Cmd_CommandAdd(pAbc, "LSV", "sokoban_aig", Sokoban_CommandAig, 0);
 } // register this new command
 
 void destroy(Abc_Frame_t *pAbc) {}
@@ -76,67 +89,1162 @@ void WriteResultsToTable(const string &mapPath, bool timeout, double duration =
     // Close the file
     outFile.close();
 }
-int Sokoban_CommandSolve(Abc_Frame_t *pAbc, int argc, char **argv)
+// switches of the sokoban command shared by all run types
+struct RunParams
+{
+    const char *pDimacsFile = nullptr; // -d
+    EncodingOptions encoding;          // -a, -p, -w
+    bool fStats = false;               // -s
+    int nThreads = 0;                  // -P, 0 = one per hardware thread
+    bool fOptimalFirst = false;        // -o
+    SatBackendType solver = SatBackendType::Bsat; // -S
+    string prover = "pdr";             // -U, unbounded engine of run type 15
+    int *pStop = nullptr;              // raised by another thread to abandon the search
+    bool fInvariants = false;          // -i
+};
+void PrintCnfStats(const SokobanSolver &Solver, int step, const EncodingOptions &encoding)
+{
+    cout << "Step " << step << ": " << Solver.numVars() << " variables, " << Solver.numClauses() << " clauses"
+         << " (at-most-one " << AmoEncodingName(encoding.amo) << ": " << Solver.get_stats().amoClauses << " clauses, "
+         << Solver.get_stats().amoVars << " auxiliary variables; push " << (encoding.push == PushEncoding::Cartesian ? "cartesian" : "auxiliary")
+         << ": " << Solver.get_stats().frameClauses << " clauses, " << Solver.get_stats().frameVars << " auxiliary variables; windows "
+         << (encoding.windows ? "on" : "off") << ": " << Solver.get_stats().prunedVars << " variables, " << Solver.get_stats().prunedClauses << " clauses pruned)" << endl;
+}
+void PrintSatStats(const SatBackend &sat, int status)
+{
+    SatStats stats = sat.Stats();
+    cout << "  " << SatBackendName(sat.type()) << ": " << (status == l_True ? "SAT" : status == l_False ? "UNSAT" : "undecided")
+         << ", " << stats.vars << " variables, " << stats.clauses << " clauses, " << stats.conflicts << " conflicts";
+    if (sat.type() == SatBackendType::Sharing)
+        cout << ", " << stats.shared << " learnt clauses shared, " << stats.imported << " imported";
+    cout << endl;
+}
+// which constraint set a run type encodes
+enum class Model
+{
+    Push,      // AllConstraints(): state literals, boxes move when pushed
+    Pull,      // PullOnlyConstraints(): the level played backwards from the targets
+    Action,    // ActionConstraints(): explicit move / push operators
+    Occupancy, // OccupancyConstraints(): one "some box is here" literal per cell
+    Macro      // MacroConstraints(): one frame per push, walking as reachability
+};
+// Encodes one horizon straight into a fresh SAT solver. The clauses are
+// only stored when a DIMACS dump was requested.
+SatBackend *EncodeHorizon(SokobanSolver &Solver, Model model, const RunParams &params, ClauseArena &arena)
+{
+    SatBackend *pSat = NewSatBackend(params.solver, params.nThreads);
+    Solver.setOptions(params.encoding);
+    Solver.StreamTo(pSat);
+    if (params.pDimacsFile)
+        Solver.KeepClauses(&arena);
+    if (model == Model::Pull)
+        Solver.PullOnlyConstraints();
+    else if (model == Model::Action)
+        Solver.ActionConstraints();
+    else if (model == Model::Occupancy)
+        Solver.OccupancyConstraints();
+    else if (model == Model::Macro)
+        Solver.MacroConstraints();
+    else
+        Solver.AllConstraints();
+    if (params.pDimacsFile)
+        Solver.WriteDimacs(params.pDimacsFile);
+    if (params.fStats)
+        PrintCnfStats(Solver, Solver.get_stepLimit(), params.encoding);
+    return pSat;
+}
+// A clause that is already falsified by the unit clauses added before it is
+// dropped by the solver and only counted, and a clause emptied by the distance
+// windows never reaches the solver, so such a horizon must not be solved
+static int SolveHorizon(const SokobanSolver &Solver, SatBackend *pSat)
+{
+    if (Solver.numFailedClauses() > 0)
+        return l_False;
+    return pSat->Solve();
+}
+// The invariants of a level are mined once and kept for the later commands
+// of the session. They are added as hard clauses, so the cache is keyed by the
+// contents of the map file: an edited level is mined again, and the same
+// level reached by another path is not.
+static const vector<StateInvariant> &LevelInvariants(const char *map)
+{
+    static std::map<string, vector<StateInvariant>> cache;
+    ifstream inFile(map);
+    stringstream contents;
+    contents << inFile.rdbuf();
+    string key = contents.str();
+    auto it = cache.find(key);
+    if (it != cache.end())
+    {
+        cout << "Invariants: " << it->second.size() << " (cached)" << endl;
+        return it->second;
+    }
+    using namespace std::chrono;
+    auto start = high_resolution_clock::now();
+    Preprocessor preprocessor(map, false);
+    preprocessor.loadMap();
+    preprocessor.TunnelIdentifying();
+    preprocessor.findDeadlockPos();
+    vector<StateInvariant> &invariants = cache[key];
+    if (preprocessor.get_playerNum() != 1)
+    {
+        cerr << "Warning: invariants are only mined for one player." << endl;
+        return invariants;
+    }
+    invariants = SokobanAig(preprocessor).MineInvariants();
+    int nConstant = count_if(invariants.begin(), invariants.end(), [](const StateInvariant &inv)
+                             { return inv.otherCell == -1; });
+    double seconds = duration_cast<microseconds>(high_resolution_clock::now() - start).count() / 1e6;
+    cout << "Invariants: " << nConstant << " constant signals, " << invariants.size() - nConstant
+         << " equivalences, mined by scorr in " << round(seconds * 1000) / 1000.0 << " seconds" << endl;
+    return invariants;
+}
+// Every horizon below the admissible bound of the preprocessor is UNSAT, so
+// the searches start there instead of at 1. The bound counts the moves that
+// bring the boxes onto the targets; the pull model only has to pull them off,
+// which can take far fewer, so it starts at 1.
+static int FirstHorizon(const Preprocessor &preprocessor, Model model)
 {
-    if (argc != 4)
+    if (model == Model::Pull)
+        return 1;
+    return max(1, model == Model::Macro ? preprocessor.getPushLowerBound() : preprocessor.getMoveLowerBound());
+}
+// Plain BMC: encode horizons from the lower bound on, from scratch, until one is satisfiable.
+static int Sokoban_RunBmc(const char *map, Model model, const RunParams &params, int verbose)
+{
+    using namespace std::chrono;
+    auto start = high_resolution_clock::now();
+    Preprocessor preprocessor(map, verbose);
+    preprocessor.loadMap();
+    preprocessor.TunnelIdentifying();
+    preprocessor.findDeadlockPos();
+    if (model == Model::Pull)
+        preprocessor.findPullRegions();
+    if (model == Model::Macro && preprocessor.get_playerNum() != 1)
     {
-        cerr << "Usage: " << argv[0] << " <map file path> <run type> <verbose>" << std::endl;
+        cerr << "The push-level encoding supports exactly one player." << endl;
         return 1;
     }
-    const char *map = argv[1];
-    int runType = atoi(argv[2]);
-    int verbose = atoi(argv[3]);
-    if (runType == 1)
+    ClauseArena arena; // only used for -d, refilled for every horizon
+    int step = FirstHorizon(preprocessor, model);
+    while (true)
     {
-        using namespace std::chrono;
-        auto start = high_resolution_clock::now();
-        Preprocessor preprocessor(map, verbose);
-        preprocessor.loadMap();
-        preprocessor.TunnelIdentifying();
-        preprocessor.findDeadlockPos();
-        int step = 1;
-        while (true)
+        if (params.pStop && *params.pStop)
+            return 0;
+        auto curr_time = high_resolution_clock::now();
+        auto TLE = hours(1);
+        if (duration_cast<seconds>(curr_time - start) >= TLE)
+        {
+            cout << "Timeout: 1 hour" << endl;
+            WriteResultsToTable(map, true);
+            return 0;
+        }
+        SokobanSolver Solver(preprocessor, model == Model::Occupancy || model == Model::Macro);
+        Solver.setStepLimit(step);
+        Solver.verbose = verbose;
+        SatBackend *pSat = EncodeHorizon(Solver, model, params, arena);
+        pSat->SetStop(params.pStop);
+
+        int status = SolveHorizon(Solver, pSat);
+        if (params.fStats)
+            PrintSatStats(*pSat, status);
+        if (status == l_Undef) // stopped from outside
+        {
+            delete pSat;
+            return 0;
+        }
+        if (status == l_True)
         {
-            auto curr_time = high_resolution_clock::now();
-            auto TLE = hours(1);
-            if (duration_cast<seconds>(curr_time - start) >= TLE)
+            vector<int> true_literals;
+            auto stop = high_resolution_clock::now();
+            auto duration = duration_cast<microseconds>(stop - start);
+            cout << "Solution found at: " << step << (model == Model::Macro ? " pushes" : " steps") << endl;
+            cout << "Lower bound: " << FirstHorizon(preprocessor, model) << (model == Model::Macro ? " pushes" : " steps") << endl;
+            double duration_seconds = duration.count() / 1e6; // Convert microseconds to seconds
+
+            // Round to three decimal places
+            duration_seconds = round(duration_seconds * 1000) / 1000.0;
+            cout << "BMC search duration: " << duration_seconds << " seconds" << endl;
+            WriteResultsToTable(map, false, duration_seconds, step);
+            if (model == Model::Macro)
             {
-                cout << "Timeout: 1 hour" << endl;
-                WriteResultsToTable(map, true);
-                return 0;
+                string moves = Solver.MacroMoves(*pSat);
+                cout << "Moves (" << moves.size() << "): " << moves << endl;
+            }
+
+            visualizeSolution(preprocessor, Solver, pSat, step, verbose);
+            delete pSat;
+            return 0;
+        }
+        delete pSat;
+        step++;
+    }
+}
+// Incremental BMC: one SokobanSolver and one SAT solver for all horizons,
+// from the lower bound on. Every step adds the clauses of the new frames
+// only. Horizon k is tested at the last frame K = k + j of the unrolling with
+// the first j frames held idle by assumptions. When it is UNSAT, the idle
+// literals in the final conflict tell how many idle frames the refutation
+// needed: with m of them, every plan of at most K - m moves is refuted as
+// well, because it can be padded with idle frames in front. The next horizon
+// is then K - m + 1.
+static int Sokoban_RunIncrementalBmc(const char *map, const RunParams &params, int verbose)
+{
+    using namespace std::chrono;
+    auto start = high_resolution_clock::now();
+    Preprocessor preprocessor(map, verbose);
+    preprocessor.loadMap();
+    preprocessor.TunnelIdentifying();
+    preprocessor.findDeadlockPos();
+    if (params.pDimacsFile)
+        cerr << "Warning: -d is ignored by the incremental run type." << endl;
+    SokobanSolver Solver(preprocessor);
+    Solver.verbose = verbose;
+    Solver.setOptions(params.encoding);
+    Solver.setIncremental();
+    Solver.setIdleSelectors();
+    SatBackend *pSat = NewSatBackend(params.solver, params.nThreads);
+    Solver.StreamTo(pSat);
+    int lookahead = 1; // idle frames in front of the horizon under test
+    vector<int> assumptions;
+    // the first ExtendTo() unrolls straight to the lower bound
+    int firstStep = FirstHorizon(preprocessor, Model::Push);
+    for (int step = firstStep;;)
+    {
+        if (duration_cast<seconds>(high_resolution_clock::now() - start) >= hours(1))
+        {
+            cout << "Timeout: 1 hour" << endl;
+            WriteResultsToTable(map, true);
+            break;
+        }
+        int last = max(step + lookahead, Solver.get_stepLimit() + 1);
+        int nIdle = last - step;
+        Solver.ExtendTo(last);
+        if (params.fStats)
+            PrintCnfStats(Solver, last, params.encoding);
+        if (Solver.numFailedClauses() > 0) // refuted without the goal: no horizon can be solved
+        {
+            cout << "No solution: the level is unsolvable" << endl;
+            break;
+        }
+        assumptions.assign(1, Solver.get_goalLit().toAbc());
+        for (int t = 0; t < nIdle; t++)
+            assumptions.push_back(Solver.get_idleLit(t).toAbc());
+        int status = pSat->Solve(assumptions.data(), assumptions.data() + assumptions.size());
+        if (status == l_True)
+        {
+            double duration_seconds = duration_cast<microseconds>(high_resolution_clock::now() - start).count() / 1e6;
+            duration_seconds = round(duration_seconds * 1000) / 1000.0;
+            cout << "Solution found at: " << step << " steps" << endl;
+            cout << "Lower bound: " << firstStep << " steps" << endl;
+            cout << "BMC search duration: " << duration_seconds << " seconds" << endl;
+            WriteResultsToTable(map, false, duration_seconds, step);
+            visualizeSolution(preprocessor, Solver, pSat, step, verbose, nIdle);
+            break;
+        }
+        // the idle frames 0 .. m - 1 cover every idle literal of the final conflict
+        int *pLits, m = 0;
+        int nLits = pSat->FinalConflict(&pLits);
+        for (int i = 0; i < nLits; i++)
+        {
+            for (int t = 0; t < nIdle; t++)
+            {
+                if (Abc_Lit2Var(pLits[i]) == Solver.get_idleLit(t).var())
+                    m = max(m, t + 1);
+            }
+        }
+        if (m == 0)
+            Solver.AddClause({~Solver.get_goalLit()});
+        if (params.fStats)
+            cout << "  horizons " << step << " to " << last - m << " refuted with " << m << " of " << nIdle << " idle frames" << endl;
+        // widen the window while whole windows are refuted, narrow it otherwise
+        lookahead = m == 0 ? min(2 * lookahead, 16) : max(1, lookahead / 2);
+        step = last - m + 1;
+    }
+    delete pSat;
+    return 0;
+}
+// Binary search on one instance: the frames are unrolled once, one at a time,
+// and "solved by k" latches turn every probe of the galloping and binary
+// search of run type 2 into a single solve call under an assumption.
+static int Sokoban_RunLatchedSearch(const char *map, const RunParams &params, int verbose)
+{
+    using namespace std::chrono;
+    auto start = high_resolution_clock::now();
+    Preprocessor preprocessor(map, verbose);
+    preprocessor.loadMap();
+    preprocessor.TunnelIdentifying();
+    preprocessor.findDeadlockPos();
+    if (params.pDimacsFile)
+        cerr << "Warning: -d is ignored by the incremental run type." << endl;
+    SokobanSolver Solver(preprocessor);
+    Solver.verbose = verbose;
+    Solver.setOptions(params.encoding);
+    Solver.setIncremental();
+    SatBackend *pSat = NewSatBackend(params.solver, params.nThreads);
+    Solver.StreamTo(pSat);
+    int nProbes = 0;
+    // solve under "solved by limit"; an UNSAT latch is fixed to false for good
+    auto probe = [&](int limit)
+    {
+        while (Solver.get_stepLimit() < limit)
+            Solver.ExtendTo(Solver.get_stepLimit() + 1);
+        if (Solver.numFailedClauses() > 0)
+            return (int)l_False;
+        int latch = Solver.get_solvedByLit(limit).toAbc();
+        nProbes++;
+        int status = pSat->Solve(&latch, &latch + 1);
+        if (status == l_False)
+            Solver.AddClause({~Solver.get_solvedByLit(limit)});
+        return status;
+    };
+    int firstStep = FirstHorizon(preprocessor, Model::Push);
+    int step = firstStep;
+    int low = firstStep;
+    while (probe(step) != l_True)
+    {
+        if (Solver.numFailedClauses() > 0) // refuted without the goal: no horizon can be solved
+        {
+            cout << "No solution: the level is unsolvable" << endl;
+            delete pSat;
+            return 0;
+        }
+        if (duration_cast<seconds>(high_resolution_clock::now() - start) >= hours(1))
+        {
+            cout << "Timeout: 1 hour, no solution found up to " << step << " steps" << endl;
+            WriteResultsToTable(map, true);
+            delete pSat;
+            return 0;
+        }
+        low = step + 1;
+        if (step < 30)
+            step += 10; // Increment by 10 initially
+        else
+            step += 8; //  Increment by 8 after reaching step 30
+    }
+    int high = step;
+    while (low < high)
+    {
+        int mid = low + (high - low) / 2;
+        if (probe(mid) == l_True)
+            high = mid; // Narrow down to smaller step range
+        else
+            low = mid + 1; // Increase the lower bound
+    }
+    double duration_seconds = duration_cast<microseconds>(high_resolution_clock::now() - start).count() / 1e6;
+    duration_seconds = round(duration_seconds * 1000) / 1000.0;
+    cout << "Solution found at: " << low << " steps (" << nProbes << " probes, " << Solver.get_stepLimit() << " frames)" << endl;
+    cout << "Lower bound: " << firstStep << " steps" << endl;
+    cout << "BMC search duration: " << duration_seconds << " seconds" << endl;
+    WriteResultsToTable(map, false, duration_seconds, low);
+    if (verbose && probe(low) == l_True) // the last probe may have been UNSAT
+        visualizeSolution(preprocessor, Solver, pSat, low, verbose);
+    delete pSat;
+    return 0;
+}
+// Parallel BMC: the workers take horizons 1, 2, ... in order, each with its own
+// SokobanSolver and SAT solver. A SAT horizon cancels the larger ones, while
+// the smaller ones run to completion, so the horizon reported is optimal.
+static int Sokoban_RunParallelBmc(const char *map, Model model, const RunParams &params, int verbose)
+{
+    using namespace std::chrono;
+    auto start = high_resolution_clock::now();
+    Preprocessor preprocessor(map, verbose);
+    preprocessor.loadMap();
+    preprocessor.TunnelIdentifying();
+    preprocessor.findDeadlockPos();
+    int nThreads = params.nThreads > 0 ? params.nThreads : max(1, (int)thread::hardware_concurrency());
+    // per-horizon output would interleave
+    RunParams workerParams = params;
+    workerParams.pDimacsFile = nullptr;
+    workerParams.fStats = false;
+    atomic<int> bestHorizon(INT_MAX);
+    atomic<int> nextHorizon(FirstHorizon(preprocessor, model));
+    mutex winnerMutex; // guards the winner, running and stopFlags
+    unique_ptr<SokobanSolver> winner;
+    SatBackend *pWinner = nullptr;
+    vector<int> running(nThreads, 0);   // horizon each worker is solving
+    vector<int> stopFlags(nThreads, 0); // raised when a smaller horizon turned out SAT
+    set<int> refuted;                   // UNSAT horizons, the others below the best may have run out of time
+    abctime nTimeToStop = Abc_Clock() + 3600 * CLOCKS_PER_SEC;
+    auto worker = [&](int id)
+    {
+        ClauseArena arena;
+        for (int step = nextHorizon++; step < bestHorizon && Abc_Clock() < nTimeToStop; step = nextHorizon++)
+        {
+            auto Solver = make_unique<SokobanSolver>(preprocessor, model == Model::Occupancy || model == Model::Macro);
+            Solver->setStepLimit(step);
+            SatBackend *pSat = EncodeHorizon(*Solver, model, workerParams, arena);
+            {
+                lock_guard<mutex> lock(winnerMutex);
+                running[id] = step;
+                stopFlags[id] = step >= bestHorizon;
             }
+            pSat->SetStop(&stopFlags[id]);
+            pSat->SetRuntimeLimit(nTimeToStop);
+            int status = SolveHorizon(*Solver, pSat);
+            if (status == l_False)
+            {
+                lock_guard<mutex> lock(winnerMutex);
+                refuted.insert(step);
+            }
+            if (status == l_True)
+            {
+                lock_guard<mutex> lock(winnerMutex);
+                if (step < bestHorizon)
+                {
+                    bestHorizon = step;
+                    swap(winner, Solver);
+                    swap(pWinner, pSat);
+                    for (int j = 0; j < nThreads; j++)
+                        stopFlags[j] |= running[j] > step;
+                }
+            }
+            if (pSat)
+                delete pSat;
+        }
+    };
+    vector<thread> workers;
+    for (int i = 0; i < nThreads; i++)
+        workers.emplace_back(worker, i);
+    for (thread &t : workers)
+        t.join();
+    if (!winner)
+    {
+        cout << "Timeout: 1 hour" << endl;
+        WriteResultsToTable(map, true);
+        return 0;
+    }
+    // the plan is only optimal when every horizon below it was refuted before the deadline
+    int firstStep = FirstHorizon(preprocessor, model);
+    if ((int)distance(refuted.begin(), refuted.lower_bound(bestHorizon)) < bestHorizon - firstStep)
+    {
+        cout << "Timeout: 1 hour" << endl;
+        cout << "Plan found at: " << bestHorizon << " steps, not proven optimal (" << nThreads << " threads)" << endl;
+        WriteResultsToTable(map, true);
+        visualizeSolution(preprocessor, *winner, pWinner, bestHorizon, verbose);
+        delete pWinner;
+        return 0;
+    }
+    double duration_seconds = duration_cast<microseconds>(high_resolution_clock::now() - start).count() / 1e6;
+    duration_seconds = round(duration_seconds * 1000) / 1000.0;
+    cout << "Solution found at: " << bestHorizon << " steps (" << nThreads << " threads)" << endl;
+    cout << "Lower bound: " << firstStep << " steps" << endl;
+    cout << "BMC search duration: " << duration_seconds << " seconds" << endl;
+    WriteResultsToTable(map, false, duration_seconds, bestHorizon);
+    visualizeSolution(preprocessor, *winner, pWinner, bestHorizon, verbose);
+    delete pWinner;
+    return 0;
+}
+// Interleaved BMC: several horizons are open at once, each with its own
+// solver, and they are time-sliced by conflict budgets. In round r the i-th
+// open horizon gets 100 * 1.5^r * gamma^i conflicts. Optimality-first keeps
+// the smallest undecided horizons open and gamma = 0.5, so most of the effort
+// goes to the smallest one. Plan-first opens horizons 4 apart with gamma = 0.9
+// to find some plan early. Either way the first plan is reported as soon as
+// it is found; the horizons below it are then closed to prove it optimal.
+static int Sokoban_RunInterleavedBmc(const char *map, const RunParams &params, int verbose)
+{
+    using namespace std::chrono;
+    auto start = high_resolution_clock::now();
+    Preprocessor preprocessor(map, verbose);
+    preprocessor.loadMap();
+    preprocessor.TunnelIdentifying();
+    preprocessor.findDeadlockPos();
+    struct Instance
+    {
+        int horizon;
+        unique_ptr<SokobanSolver> Solver;
+        SatBackend *pSat;
+    };
+    const int nOpenMax = 8;
+    const double gamma = params.fOptimalFirst ? 0.5 : 0.9;
+    const int stride = params.fOptimalFirst ? 1 : 4;
+    RunParams instanceParams = params;
+    instanceParams.pDimacsFile = nullptr; // the file would hold a random open horizon
+    ClauseArena arena;
+    // the horizons below the lower bound count as decided from the start
+    int firstStep = FirstHorizon(preprocessor, Model::Push);
+    vector<Instance> open;      // sorted by horizon
+    vector<bool> decided(firstStep, true); // decided[k]: horizon k has been solved
+    int best = INT_MAX, nRounds = 0;
+    unique_ptr<SokobanSolver> winner;
+    SatBackend *pWinner = nullptr;
+    auto isDecided = [&](int k) { return k < (int)decided.size() && decided[k]; };
+    auto openHorizon = [&](int k)
+    {
+        auto Solver = make_unique<SokobanSolver>(preprocessor);
+        Solver->setStepLimit(k);
+        SatBackend *pSat = EncodeHorizon(*Solver, Model::Push, instanceParams, arena);
+        auto pos = upper_bound(open.begin(), open.end(), k, [](int h, const Instance &inst) { return h < inst.horizon; });
+        open.insert(pos, Instance{k, move(Solver), pSat});
+    };
+    for (double budget = 100; ; budget *= 1.5, nRounds++)
+    {
+        // refill: before the first plan in plan-first mode, probe further out;
+        // otherwise take the smallest horizons nobody has decided yet
+        while ((int)open.size() < nOpenMax)
+        {
+            int next = -1;
+            if (best == INT_MAX && stride > 1)
+                next = open.empty() ? firstStep : open.back().horizon + stride;
+            else
+            {
+                for (int k = firstStep; k < best && next == -1; k++)
+                {
+                    if (!isDecided(k) && none_of(open.begin(), open.end(), [k](const Instance &inst) { return inst.horizon == k; }))
+                        next = k;
+                }
+            }
+            if (next == -1)
+                break;
+            openHorizon(next);
+        }
+        if (open.empty())
+            break;
+        if (duration_cast<seconds>(high_resolution_clock::now() - start) >= hours(1))
+        {
+            cout << "Time limit reached with " << open.size() << " horizons open" << endl;
+            break;
+        }
+        for (size_t i = 0; i < open.size(); i++)
+        {
+            Instance &inst = open[i];
+            int status = l_False;
+            if (inst.Solver->numFailedClauses() == 0)
+            {
+                inst.pSat->SetConflictBudget(max(1, (int)(budget * pow(gamma, i))));
+                status = inst.pSat->Solve();
+            }
+            if (status == l_Undef)
+                continue;
+            if (inst.horizon >= (int)decided.size())
+                decided.resize(inst.horizon + 1, false);
+            decided[inst.horizon] = true;
+            if (status == l_True && inst.horizon < best)
+            {
+                best = inst.horizon;
+                if (pWinner)
+                    delete pWinner;
+                winner = move(inst.Solver);
+                pWinner = inst.pSat;
+                inst.pSat = nullptr;
+                double elapsed = duration_cast<microseconds>(high_resolution_clock::now() - start).count() / 1e6;
+                cout << "Plan found at: " << best << " steps after " << round(elapsed * 1000) / 1000.0 << " seconds" << endl;
+            }
+            if (inst.pSat)
+                delete inst.pSat;
+            inst.pSat = nullptr;
+        }
+        // drop the decided horizons and everything a plan has made useless
+        for (Instance &inst : open)
+        {
+            if (inst.pSat && inst.horizon >= best)
+            {
+                delete inst.pSat;
+                inst.pSat = nullptr;
+            }
+        }
+        open.erase(remove_if(open.begin(), open.end(), [](const Instance &inst) { return !inst.pSat; }), open.end());
+    }
+    for (Instance &inst : open)
+        delete inst.pSat;
+    double duration_seconds = duration_cast<microseconds>(high_resolution_clock::now() - start).count() / 1e6;
+    duration_seconds = round(duration_seconds * 1000) / 1000.0;
+    if (!pWinner)
+    {
+        cout << "No solution found" << endl;
+        return 0;
+    }
+    cout << (open.empty() ? "Solution found at: " : "Best plan found: ") << best << " steps (" << nRounds << " rounds)" << endl;
+    cout << "Lower bound: " << firstStep << " steps" << endl;
+    cout << "BMC search duration: " << duration_seconds << " seconds" << endl;
+    WriteResultsToTable(map, false, duration_seconds, best);
+    visualizeSolution(preprocessor, *winner, pWinner, best, verbose);
+    delete pWinner;
+    return 0;
+}
+// Portfolio BMC: every horizon is encoded once per configuration (SAT backend
+// and seed) and the copies race on their own threads. The first definitive
+// answer wins and raises the shared stop flag of the others. The wins per
+// configuration are printed at the end to help choosing the -S default.
+static int Sokoban_RunPortfolioBmc(const char *map, const RunParams &params, int verbose)
+{
+    using namespace std::chrono;
+    auto start = high_resolution_clock::now();
+    Preprocessor preprocessor(map, verbose);
+    preprocessor.loadMap();
+    preprocessor.TunnelIdentifying();
+    preprocessor.findDeadlockPos();
+    // backends first, then the same backends again with other seeds
+    const SatBackendType backends[] = {SatBackendType::Bsat, SatBackendType::Glucose2, SatBackendType::Satoko, SatBackendType::Glucose};
+    int nConfigs = params.nThreads > 0 ? params.nThreads : 4;
+    vector<pair<SatBackendType, int>> configs;
+    for (int i = 0; i < nConfigs; i++)
+        configs.push_back({backends[i % 4], i / 4});
+    RunParams memberParams = params;
+    memberParams.pDimacsFile = nullptr;
+    memberParams.fStats = false;
+    abctime nTimeToStop = Abc_Clock() + 3600 * CLOCKS_PER_SEC;
+    vector<int> wins(nConfigs, 0);
+    vector<ClauseArena> arenas(nConfigs);
+    int firstStep = FirstHorizon(preprocessor, Model::Push);
+    for (int step = firstStep;; step++)
+    {
+        int stop = 0;
+        int winnerId = -1, winnerStatus = l_Undef;
+        mutex winnerMutex;
+        unique_ptr<SokobanSolver> winner;
+        SatBackend *pWinner = nullptr;
+        auto member = [&](int id)
+        {
+            auto Solver = make_unique<SokobanSolver>(preprocessor);
+            Solver->setStepLimit(step);
+            RunParams ownParams = memberParams;
+            ownParams.solver = configs[id].first;
+            SatBackend *pSat = EncodeHorizon(*Solver, Model::Push, ownParams, arenas[id]);
+            pSat->Diversify(configs[id].second);
+            pSat->SetStop(&stop);
+            pSat->SetRuntimeLimit(nTimeToStop);
+            int status = SolveHorizon(*Solver, pSat);
+            lock_guard<mutex> lock(winnerMutex);
+            if (status != l_Undef && winnerId == -1)
+            {
+                winnerId = id;
+                winnerStatus = status;
+                stop = 1;
+                swap(winner, Solver);
+                swap(pWinner, pSat);
+            }
+            delete pSat;
+        };
+        vector<thread> members;
+        for (int i = 0; i < nConfigs; i++)
+            members.emplace_back(member, i);
+        for (thread &t : members)
+            t.join();
+        if (winnerId == -1)
+        {
+            cout << "Timeout: 1 hour" << endl;
+            WriteResultsToTable(map, true);
+            return 0;
+        }
+        wins[winnerId]++;
+        if (params.fStats)
+            cout << "Step " << step << ": " << (winnerStatus == l_True ? "SAT" : "UNSAT") << " first by "
+                 << SatBackendName(configs[winnerId].first) << " seed " << configs[winnerId].second << endl;
+        if (winnerStatus == l_True)
+        {
+            double duration_seconds = duration_cast<microseconds>(high_resolution_clock::now() - start).count() / 1e6;
+            duration_seconds = round(duration_seconds * 1000) / 1000.0;
+            cout << "Solution found at: " << step << " steps" << endl;
+            cout << "Lower bound: " << firstStep << " steps" << endl;
+            cout << "BMC search duration: " << duration_seconds << " seconds" << endl;
+            cout << "Portfolio wins over " << step - firstStep + 1 << " horizons:";
+            for (int i = 0; i < nConfigs; i++)
+                cout << " " << SatBackendName(configs[i].first) << "/" << configs[i].second << " " << wins[i];
+            cout << endl;
+            WriteResultsToTable(map, false, duration_seconds, step);
+            visualizeSolution(preprocessor, *winner, pWinner, step, verbose);
+            delete pWinner;
+            return 0;
+        }
+        delete pWinner;
+    }
+}
+// Cube-and-conquer BMC: every horizon is encoded once and split into cubes by
+// the player's cell at a few frames (SokobanSolver::PlayerCubes()). The
+// workers copy the CNF into their own SAT solvers and take the next open cube
+// from a shared cursor, so a worker that finished its cubes early goes on with
+// the remaining ones. The first SAT cube cancels the others; the horizon is
+// UNSAT once every cube is.
+static int Sokoban_RunCubeBmc(const char *map, const RunParams &params, int verbose)
+{
+    using namespace std::chrono;
+    auto start = high_resolution_clock::now();
+    Preprocessor preprocessor(map, verbose);
+    preprocessor.loadMap();
+    preprocessor.TunnelIdentifying();
+    preprocessor.findDeadlockPos();
+    int nThreads = params.nThreads > 0 ? params.nThreads : max(1, (int)thread::hardware_concurrency());
+    // the cubes already keep the threads busy
+    SatBackendType solver = params.solver == SatBackendType::Sharing ? SatBackendType::Satoko : params.solver;
+    abctime nTimeToStop = Abc_Clock() + 3600 * CLOCKS_PER_SEC;
+    ClauseArena arena;
+    int firstStep = FirstHorizon(preprocessor, Model::Push);
+    for (int step = firstStep;; step++)
+    {
+        SokobanSolver Solver(preprocessor);
+        Solver.setStepLimit(step);
+        Solver.verbose = verbose;
+        Solver.setOptions(params.encoding);
+        Solver.KeepClauses(&arena);
+        Solver.AllConstraints();
+        if (params.pDimacsFile)
+            Solver.WriteDimacs(params.pDimacsFile);
+        if (params.fStats)
+            PrintCnfStats(Solver, step, params.encoding);
+        if (Solver.numFailedClauses() > 0)
+            continue;
+        // split at one frame, or at two when one leaves too few cubes to balance the load
+        vector<vector<Lit>> cubes = Solver.PlayerCubes(1);
+        if ((int)cubes.size() < 4 * nThreads)
+            cubes = Solver.PlayerCubes(2);
+        atomic<size_t> nextCube(0);
+        atomic<int> nRefuted(0);
+        int found = 0;
+        bool undecided = false;
+        mutex winnerMutex; // guards found, undecided and pWinner
+        SatBackend *pWinner = nullptr;
+        auto worker = [&]()
+        {
+            SatBackend *pSat = NewSatBackend(solver);
+            Solver.CnfWriter(pSat);
+            pSat->SetStop(&found);
+            pSat->SetRuntimeLimit(nTimeToStop);
+            vector<int> assumptions;
+            for (size_t i = nextCube++; i < cubes.size() && !found; i = nextCube++)
+            {
+                assumptions.clear();
+                for (const Lit &lit : cubes[i])
+                    assumptions.push_back(lit.toAbc());
+                int status = pSat->Solve(assumptions.data(), assumptions.data() + assumptions.size());
+                if (status == l_False)
+                {
+                    nRefuted++;
+                    continue;
+                }
+                lock_guard<mutex> lock(winnerMutex);
+                if (status == l_True && !found)
+                {
+                    found = 1;
+                    swap(pWinner, pSat);
+                }
+                else if (status == l_Undef && !found)
+                    undecided = true;
+                break;
+            }
+            delete pSat;
+        };
+        vector<thread> workers;
+        for (int i = 0; i < nThreads; i++)
+            workers.emplace_back(worker);
+        for (thread &t : workers)
+            t.join();
+        if (params.fStats)
+            cout << "  " << cubes.size() << " cubes, " << nRefuted << " refuted" << (found ? ", one satisfiable" : "") << endl;
+        if (undecided)
+        {
+            cout << "Timeout: 1 hour" << endl;
+            WriteResultsToTable(map, true);
+            return 0;
+        }
+        if (found)
+        {
+            double duration_seconds = duration_cast<microseconds>(high_resolution_clock::now() - start).count() / 1e6;
+            duration_seconds = round(duration_seconds * 1000) / 1000.0;
+            cout << "Solution found at: " << step << " steps" << endl;
+            cout << "Lower bound: " << firstStep << " steps" << endl;
+            cout << "BMC search duration: " << duration_seconds << " seconds" << endl;
+            WriteResultsToTable(map, false, duration_seconds, step);
+            visualizeSolution(preprocessor, Solver, pWinner, step, verbose);
+            delete pWinner;
+            return 0;
+        }
+    }
+}
+// PDR polls a callback with its run id instead of a flag
+static int *pProverStop = nullptr;
+static int ProverStop(int) { return pProverStop && *pProverStop; }
+// Model checks the sequential AIG of a level with an unbounded engine: 1 when
+// the solved output can never be 1, 0 with a plan in pAig->pSeqModel, -1 when
+// stopped or out of time.
+static int ProveUnsolvable(Aig_Man_t *pAig, const string &engine, int *pStop)
+{
+    if (engine == "pdr")
+    {
+        Pdr_Par_t Pars;
+        Pdr_ManSetDefaultParams(&Pars);
+        Pars.nTimeOut = 3600;
+        Pars.fSilent = 1;
+        Pars.fNotVerbose = 1;
+        Pars.pFuncStop = ProverStop;
+        pProverStop = pStop;
+        return Pdr_ManSolve(pAig, &Pars);
+    }
+    // interpolation takes no stop callback, so it runs in time slices of growing length
+    Inter_ManParams_t Pars;
+    Inter_ManSetDefaultParams(&Pars);
+    for (int slice = 1; slice <= 3600 && !*pStop; slice *= 2)
+    {
+        int depth;
+        Pars.nSecLimit = slice;
+        int status = Inter_ManPerformInterpolation(pAig, &Pars, &depth);
+        if (status != -1)
+            return status;
+    }
+    return -1;
+}
+// BMC raced against an unbounded engine on the sequential AIG of the level
+// (SokobanAig): PDR, or interpolation with -U int. A proof that no state
+// with every target covered can be reached means the level is unsolvable
+// and stops BMC; a plan found by BMC stops the prover. A counter-example of
+// the prover is not necessarily the shortest plan, so it only bounds the
+// horizon and BMC goes on to the optimal one.
+static int Sokoban_RunProvedBmc(const char *map, const RunParams &params, int verbose)
+{
+    using namespace std::chrono;
+    auto start = high_resolution_clock::now();
+    Preprocessor preprocessor(map, false);
+    preprocessor.loadMap();
+    preprocessor.TunnelIdentifying();
+    preprocessor.findDeadlockPos();
+    if (preprocessor.get_playerNum() != 1)
+    {
+        cerr << "Warning: the AIG model supports exactly one player, running BMC alone." << endl;
+        return Sokoban_RunBmc(map, Model::Push, params, verbose);
+    }
+    // shared with the prover thread, which may outlive this call, see below
+    struct ProverRun
+    {
+        Aig_Man_t *pAig = nullptr;
+        int stop = 0;    // raised when BMC has answered
+        int bmcStop = 0; // raised when the prover has proved the level unsolvable
+        int status = -1;
+        double seconds = 0;
+        atomic<bool> done{false};
+        ~ProverRun() { Aig_ManStop(pAig); }
+    };
+    auto run = make_shared<ProverRun>();
+    Gia_Man_t *pGia = SokobanAig(preprocessor).Build();
+    run->pAig = Gia_ManToAigSimple(pGia);
+    Gia_ManStop(pGia);
+    thread prover([run, engine = params.prover, start]()
+                  {
+        int status = ProveUnsolvable(run->pAig, engine, &run->stop);
+        run->seconds = duration_cast<microseconds>(high_resolution_clock::now() - start).count() / 1e6;
+        run->status = status;
+        if (status == 1)
+            run->bmcStop = 1;
+        run->done = true; });
+    RunParams bmcParams = params;
+    bmcParams.pStop = &run->bmcStop;
+    Sokoban_RunBmc(map, Model::Push, bmcParams, verbose);
+    run->stop = 1;
+    // PDR polls the stop flag; interpolation only notices it between time slices, so
+    // a running slice is left to finish on its own thread, which keeps run alive
+    if (params.prover == "pdr" || run->bmcStop || run->done)
+        prover.join();
+    else
+    {
+        prover.detach();
+        return 0;
+    }
+    double proverSeconds = round(run->seconds * 1000) / 1000.0;
+    if (run->status == 1)
+    {
+        cout << "No solution: the level is unsolvable (proved by " << params.prover << ")" << endl;
+        cout << "Proof duration: " << proverSeconds << " seconds" << endl;
+        WriteResultsToTable(map, true);
+    }
+    else if (run->status == 0 && run->pAig->pSeqModel)
+        cout << params.prover << " found a plan of at most " << run->pAig->pSeqModel->iFrame << " steps after " << proverSeconds << " seconds" << endl;
+    return 0;
+}
+// Solves one instance of the k-induction step or forward case over stepLimit
+// moves, restricted to simple paths: as long as a model repeats a state, the
+// repeated pairs are made distinct and the instance is solved again.
+static int SolveSimplePath(const Preprocessor &preprocessor, InductionCase induction, int stepLimit, const RunParams &params, int &nDistinct)
+{
+    SokobanSolver Solver(preprocessor);
+    Solver.setStepLimit(stepLimit);
+    Solver.setOptions(params.encoding);
+    Solver.setInductionCase(induction);
+    SatBackend *pSat = NewSatBackend(params.solver, params.nThreads);
+    Solver.StreamTo(pSat);
+    Solver.AllConstraints();
+    int status = SolveHorizon(Solver, pSat);
+    while (status == l_True)
+    {
+        vector<pair<int, int>> equal = Solver.EqualStates(*pSat);
+        if (equal.empty())
+            break;
+        for (const auto &[i, j] : equal)
+            Solver.DistinctStates(i, j);
+        nDistinct += equal.size();
+        status = SolveHorizon(Solver, pSat);
+    }
+    delete pSat;
+    return status;
+}
+// k-induction on "the level is not solved", for k = 1, 2, ...: the base case
+// is the BMC horizon k, the step case is an unsolved simple path of k states
+// from anywhere followed by the goal, the forward case is an unsolved simple
+// path of k + 1 states from the initial state. Once the base cases up to k are
+// UNSAT, an UNSAT step case proves that no plan has k moves or more, and an
+// UNSAT forward case that every shortest plan has at most k moves; either way
+// the level is unsolvable. Horizons below the lower bound skip the base case.
+static int Sokoban_RunInduction(const char *map, const RunParams &params, int verbose)
+{
+    using namespace std::chrono;
+    auto start = high_resolution_clock::now();
+    Preprocessor preprocessor(map, verbose);
+    preprocessor.loadMap();
+    preprocessor.TunnelIdentifying();
+    preprocessor.findDeadlockPos();
+    ClauseArena arena; // only used for -d, refilled for every horizon
+    int firstStep = FirstHorizon(preprocessor, Model::Push);
+    for (int step = 1;; step++)
+    {
+        if (duration_cast<seconds>(high_resolution_clock::now() - start) >= hours(1))
+        {
+            cout << "Timeout: 1 hour" << endl;
+            WriteResultsToTable(map, true);
+            return 0;
+        }
+        if (step >= firstStep)
+        {
             SokobanSolver Solver(preprocessor);
             Solver.setStepLimit(step);
             Solver.verbose = verbose;
-            sat_solver *pSat = sat_solver_new();
-            Solver.AllConstraints();
-            Solver.CnfWriter(pSat);
-
-            int status = sat_solver_solve(pSat, nullptr, nullptr, 0, 0, 0, 0);
+            SatBackend *pSat = EncodeHorizon(Solver, Model::Push, params, arena);
+            int status = SolveHorizon(Solver, pSat);
+            if (params.fStats)
+                PrintSatStats(*pSat, status);
             if (status == l_True)
             {
-                vector<int> true_literals;
-                auto stop = high_resolution_clock::now();
-                auto duration = duration_cast<microseconds>(stop - start);
-                cout << "Solution found at: " << step << " steps" << endl;
-                double duration_seconds = duration.count() / 1e6; // Convert microseconds to seconds
-
-                // Round to three decimal places
+                double duration_seconds = duration_cast<microseconds>(high_resolution_clock::now() - start).count() / 1e6;
                 duration_seconds = round(duration_seconds * 1000) / 1000.0;
+                cout << "Solution found at: " << step << " steps" << endl;
+                cout << "Lower bound: " << firstStep << " steps" << endl;
                 cout << "BMC search duration: " << duration_seconds << " seconds" << endl;
                 WriteResultsToTable(map, false, duration_seconds, step);
-
-                if (!verbose)
-                {
-                    return 0;
-                }
                 visualizeSolution(preprocessor, Solver, pSat, step, verbose);
+                delete pSat;
                 return 0;
             }
-            sat_solver_delete(pSat);
-            step++;
+            delete pSat;
+        }
+        int nDistinct = 0;
+        int stepStatus = SolveSimplePath(preprocessor, InductionCase::Step, step, params, nDistinct);
+        int forwardStatus = stepStatus == l_False ? l_True : SolveSimplePath(preprocessor, InductionCase::Forward, step, params, nDistinct);
+        if (params.fStats)
+            cout << "  induction " << step << ": step case " << (stepStatus == l_False ? "UNSAT" : "SAT") << ", forward case "
+                 << (stepStatus == l_False ? "skipped" : forwardStatus == l_False ? "UNSAT" : "SAT") << ", " << nDistinct << " simple-path constraints" << endl;
+        if (stepStatus == l_False || forwardStatus == l_False)
+        {
+            double duration_seconds = duration_cast<microseconds>(high_resolution_clock::now() - start).count() / 1e6;
+            duration_seconds = round(duration_seconds * 1000) / 1000.0;
+            if (stepStatus == l_False)
+                cout << "No solution: the level is unsolvable (" << step << "-induction)" << endl;
+            else
+                cout << "No solution: the level is unsolvable (every shortest plan has at most " << step << " steps)" << endl;
+            cout << "Proof duration: " << duration_seconds << " seconds" << endl;
+            WriteResultsToTable(map, true);
+            return 0;
         }
     }
+}
+// BMC over the CNF of the sequential AIG of the level (SokobanAig), one frame
+// optimised with &dc2 and &fraig and instantiated per horizon. Invalid moves
+// keep the state in that model, so the first satisfiable horizon is optimal.
+// With -s, every horizon is also encoded and solved with the hand-written
+// constraints of run type 1 for comparison.
+static int Sokoban_RunAigCnfBmc(const char *map, const RunParams &params, int verbose)
+{
+    using namespace std::chrono;
+    auto start = high_resolution_clock::now();
+    Preprocessor preprocessor(map, verbose);
+    preprocessor.loadMap();
+    preprocessor.TunnelIdentifying();
+    preprocessor.findDeadlockPos();
+    if (preprocessor.get_playerNum() != 1)
+    {
+        cerr << "Warning: the AIG model supports exactly one player, running BMC alone." << endl;
+        return Sokoban_RunBmc(map, Model::Push, params, verbose);
+    }
+    SokobanAig model(preprocessor);
+    Gia_Man_t *pGia = model.Build();
+    FrameCnf cnf(pGia, true);
+    Gia_ManStop(pGia);
+    if (params.fStats)
+        cout << "Frame AIG: " << cnf.nAndsBefore << " and nodes, " << cnf.nAndsAfter << " after &dc2 and &fraig; CNF: "
+             << cnf.nFrameVars << " variables, " << cnf.nFrameClauses << " clauses per frame" << endl;
+    ClauseArena arena; // only used for -d
+    int firstStep = FirstHorizon(preprocessor, Model::Push);
+    for (int step = firstStep;; step++)
+    {
+        if (duration_cast<seconds>(high_resolution_clock::now() - start) >= hours(1))
+        {
+            cout << "Timeout: 1 hour" << endl;
+            WriteResultsToTable(map, true);
+            return 0;
+        }
+        SatBackend *pSat = NewSatBackend(params.solver, params.nThreads);
+        cnf.Unroll(step + 1, pSat);
+        int goal = cnf.OutputLit(step);
+        pSat->AddClause(&goal, &goal + 1);
+        pSat->SetNumVars(cnf.numVars());
+        auto solveStart = high_resolution_clock::now();
+        int status = pSat->Solve();
+        double solveSeconds = duration_cast<microseconds>(high_resolution_clock::now() - solveStart).count() / 1e6;
+        if (params.fStats)
+        {
+            cout << "Step " << step << ": AIG CNF " << cnf.numVars() << " variables, " << cnf.numClauses() << " clauses, "
+                 << (status == l_True ? "SAT" : "UNSAT") << " in " << solveSeconds << " seconds" << endl;
+            SokobanSolver Solver(preprocessor);
+            Solver.setStepLimit(step);
+            SatBackend *pHand = EncodeHorizon(Solver, Model::Push, params, arena);
+            solveStart = high_resolution_clock::now();
+            int handStatus = SolveHorizon(Solver, pHand);
+            solveSeconds = duration_cast<microseconds>(high_resolution_clock::now() - solveStart).count() / 1e6;
+            cout << "Step " << step << ": hand encoding " << Solver.numVars() << " variables, " << Solver.numClauses() << " clauses, "
+                 << (handStatus == l_True ? "SAT" : "UNSAT") << " in " << solveSeconds << " seconds" << endl;
+            delete pHand;
+        }
+        if (status == l_True)
+        {
+            double duration_seconds = duration_cast<microseconds>(high_resolution_clock::now() - start).count() / 1e6;
+            duration_seconds = round(duration_seconds * 1000) / 1000.0;
+            Abc_Cex_t *pCex = cnf.ModelToCex(*pSat, step);
+            bool solved;
+            string moves = model.CexToMoves(pCex, solved);
+            Abc_CexFree(pCex);
+            delete pSat;
+            cout << "Solution found at: " << step << " steps" << endl;
+            cout << "Lower bound: " << firstStep << " steps" << endl;
+            cout << "BMC search duration: " << duration_seconds << " seconds" << endl;
+            cout << "Moves (" << moves.size() << "): " << moves << endl;
+            if (!solved)
+                cerr << "Warning: the moves do not solve the level." << endl;
+            WriteResultsToTable(map, false, duration_seconds, step);
+            return 0;
+        }
+        delete pSat;
+    }
+}
+static int Sokoban_Usage(const char *command)
+{
+    cerr << "Usage: " << command << " [-a <encoding>] [-p <encoding>] [-w] [-S <solver>] [-P <num>] [-o] [-U <engine>] [-d <file>] [-s] [-i] <map file path> <run type> <verbose>" << endl;
+    cerr << "\t-a <encoding> : at-most-one encoding for placement and collision constraints:" << endl;
+    cerr << "\t                auto, pairwise, sequential, commander, product or bimander [default = auto]" << endl;
+    cerr << "\t-p <encoding> : push (frame axiom) encoding: auxiliary or cartesian [default = auxiliary]" << endl;
+    cerr << "\t-w            : toggle pruning by player / box distance windows [default = yes]" << endl;
+    cerr << "\t-S <solver>   : SAT solver: bsat, glucose2, satoko, glucose, or sharing for -P satoko" << endl;
+    cerr << "\t                threads exchanging learnt clauses [default = bsat]" << endl;
+    cerr << "\t-P <num>      : number of threads of run types 11, 14 and of -S sharing [default = one per hardware thread]" << endl;
+    cerr << "\t                or of configurations of run type 13 [default = 4, one per SAT solver]" << endl;
+    cerr << "\t-o            : toggle optimality-first scheduling of the interleaved run type [default = plan-first]" << endl;
+    cerr << "\t-U <engine>   : unbounded engine of run type 15: pdr or int (interpolation) [default = pdr]" << endl;
+    cerr << "\t-d <file>     : dump the CNF of every encoded horizon to <file> in DIMACS (the last one is kept)" << endl;
+    cerr << "\t-s            : print variable and clause counts of every encoded horizon" << endl;
+    cerr << "\t-i            : toggle adding the invariants mined by signal correspondence on the" << endl;
+    cerr << "\t                sequential AIG to every frame of the state encoding [default = no]" << endl;
+    cerr << "\trun type      : 1 BMC, 2 binary search, 3 pull binary search, 4 pull BMC, 5 pull coarse search," << endl;
+    cerr << "\t                6 BMC with the move / push operator encoding, 7 BMC with box occupancy literals," << endl;
+    cerr << "\t                8 push-optimal BMC (one frame per push, single player), 9 incremental BMC," << endl;
+    cerr << "\t                10 binary search under \"solved by k\" assumptions on one instance," << endl;
+    cerr << "\t                11 parallel BMC over horizons (-P threads), 12 interleaved BMC with conflict budgets (-o)," << endl;
+    cerr << "\t                13 BMC with a portfolio of SAT backends racing on every horizon (-P configurations)," << endl;
+    cerr << "\t                14 cube-and-conquer BMC, cubes on the player's early cells solved by -P threads," << endl;
+    cerr << "\t                15 BMC raced against an unsolvability proof on the sequential AIG (-U)," << endl;
+    cerr << "\t                16 k-induction with simple-path constraints, stops on unsolvable levels," << endl;
+    cerr << "\t                17 BMC over the optimised CNF of one frame of the sequential AIG (-s compares)" << endl;
+    return 1;
+}
+int Sokoban_CommandSolve(Abc_Frame_t *pAbc, int argc, char **argv)
+{
+    RunParams params;
+    int c;
+    Extra_UtilGetoptReset();
+    while ((c = Extra_UtilGetopt(argc, argv, "apwSPoUdsih")) != EOF)
+    {
+        switch (c)
+        {
+        case 'a':
+            if (globalUtilOptind >= argc || !ParseAmoEncoding(argv[globalUtilOptind], params.encoding.amo))
+            {
+                cerr << "Command line switch \"-a\" should be followed by an at-most-one encoding." << endl;
+                return Sokoban_Usage(argv[0]);
+            }
+            globalUtilOptind++;
+            break;
+        case 'p':
+            if (globalUtilOptind >= argc)
+            {
+                cerr << "Command line switch \"-p\" should be followed by a push encoding." << endl;
+                return Sokoban_Usage(argv[0]);
+            }
+            if (!strcmp(argv[globalUtilOptind], "auxiliary"))
+                params.encoding.push = PushEncoding::Auxiliary;
+            else if (!strcmp(argv[globalUtilOptind], "cartesian"))
+                params.encoding.push = PushEncoding::Cartesian;
+            else
+            {
+                cerr << "Unknown push encoding \"" << argv[globalUtilOptind] << "\"." << endl;
+                return Sokoban_Usage(argv[0]);
+            }
+            globalUtilOptind++;
+            break;
+        case 'd':
+            if (globalUtilOptind >= argc)
+            {
+                cerr << "Command line switch \"-d\" should be followed by a file name." << endl;
+                return Sokoban_Usage(argv[0]);
+            }
+            params.pDimacsFile = argv[globalUtilOptind++];
+            break;
+        case 'w':
+            params.encoding.windows ^= 1;
+            break;
+        case 'S':
+            if (globalUtilOptind >= argc || !ParseSatBackend(argv[globalUtilOptind], params.solver))
+            {
+                cerr << "Command line switch \"-S\" should be followed by a SAT solver name." << endl;
+                return Sokoban_Usage(argv[0]);
+            }
+            globalUtilOptind++;
+            break;
+        case 'P':
+            if (globalUtilOptind >= argc)
+            {
+                cerr << "Command line switch \"-P\" should be followed by an integer." << endl;
+                return Sokoban_Usage(argv[0]);
+            }
+            params.nThreads = atoi(argv[globalUtilOptind++]);
+            if (params.nThreads < 0)
+                return Sokoban_Usage(argv[0]);
+            break;
+        case 'o':
+            params.fOptimalFirst ^= 1;
+            break;
+        case 'U':
+            if (globalUtilOptind >= argc || (strcmp(argv[globalUtilOptind], "pdr") && strcmp(argv[globalUtilOptind], "int")))
+            {
+                cerr << "Command line switch \"-U\" should be followed by pdr or int." << endl;
+                return Sokoban_Usage(argv[0]);
+            }
+            params.prover = argv[globalUtilOptind++];
+            break;
+        case 's':
+            params.fStats ^= 1;
+            break;
+        case 'i':
+            params.fInvariants ^= 1;
+            break;
+        default:
+            return Sokoban_Usage(argv[0]);
+        }
+    }
+    if (argc - globalUtilOptind != 3)
+        return Sokoban_Usage(argv[0]);
+    const char *map = argv[globalUtilOptind];
+    int runType = atoi(argv[globalUtilOptind + 1]);
+    int verbose = atoi(argv[globalUtilOptind + 2]);
+    if (params.fInvariants)
+        params.encoding.invariants = &LevelInvariants(map);
+    if (runType == 1)
+        return Sokoban_RunBmc(map, Model::Push, params, verbose);
     else if (runType == 2) // binary search
     {
         using namespace std::chrono;
@@ -145,27 +1253,28 @@ int Sokoban_CommandSolve(Abc_Frame_t *pAbc, int argc, char **argv)
         preprocessor.loadMap();
         preprocessor.TunnelIdentifying();
         preprocessor.findDeadlockPos();
-        int step = 1;
+        ClauseArena arena; // only used for -d, refilled for every horizon
+        int firstStep = FirstHorizon(preprocessor, Model::Push);
+        int step = firstStep;
         int increment = 10;
         int foundStep = -1;
+        int lastUnsat = firstStep - 1; // every horizon up to here is UNSAT
 
         while (true)
         {
             SokobanSolver Solver(preprocessor);
             Solver.setStepLimit(step);
-            sat_solver *pSat = sat_solver_new();
-            Solver.AllConstraints();
-            Solver.CnfWriter(pSat);
+            SatBackend *pSat = EncodeHorizon(Solver, Model::Push, params, arena);
 
-            int status = sat_solver_solve(pSat, nullptr, nullptr, 0, 0, 0, 0);
+            int status = SolveHorizon(Solver, pSat);
 
+            delete pSat;
             if (status == l_True)
             {
                 foundStep = step;
                 break;
             }
-
-            sat_solver_delete(pSat);
+            lastUnsat = step;
 
             if (step < 30)
                 step += 10; // Increment by 10 initially
@@ -174,7 +1283,7 @@ int Sokoban_CommandSolve(Abc_Frame_t *pAbc, int argc, char **argv)
         }
 
         // Perform binary search to find the minimum step
-        int low = max(1, step - (step <= 30 ? 10 : 8));
+        int low = lastUnsat + 1;
         int high = foundStep;
 
         while (low < high)
@@ -183,22 +1292,21 @@ int Sokoban_CommandSolve(Abc_Frame_t *pAbc, int argc, char **argv)
 
             SokobanSolver Solver(preprocessor);
             Solver.setStepLimit(mid);
-            sat_solver *pSat = sat_solver_new();
-            Solver.AllConstraints();
-            Solver.CnfWriter(pSat);
+            SatBackend *pSat = EncodeHorizon(Solver, Model::Push, params, arena);
 
-            int status = sat_solver_solve(pSat, nullptr, nullptr, 0, 0, 0, 0);
+            int status = SolveHorizon(Solver, pSat);
 
             if (status == l_True)
                 high = mid; // Narrow down to smaller step range
             else
                 low = mid + 1; // Increase the lower bound
-            sat_solver_delete(pSat);
+            delete pSat;
         }
         auto stop = high_resolution_clock::now();
         auto duration = duration_cast<seconds>(stop - start);
 
         cout << "Solution found at: " << low << " steps" << endl;
+        cout << "Lower bound: " << firstStep << " steps" << endl;
         cout << "BMC search duration: " << duration.count() << " seconds" << endl;
     }
     else if (runType == 3) // binary search with pull only constraints
@@ -211,6 +1319,7 @@ int Sokoban_CommandSolve(Abc_Frame_t *pAbc, int argc, char **argv)
         preprocessor.TunnelIdentifying();
         preprocessor.findDeadlockPos();
         preprocessor.findPullRegions();
+        ClauseArena arena; // only used for -d, refilled for every horizon
         int step = 100;
         int increment = 10;
         int foundStep = -1;
@@ -220,20 +1329,19 @@ int Sokoban_CommandSolve(Abc_Frame_t *pAbc, int argc, char **argv)
             SokobanSolver Solver(preprocessor);
             cout << "step: " << step << endl;
             Solver.setStepLimit(step);
-            sat_solver *pSat = sat_solver_new();
-            Solver.PullOnlyConstraints();
-            Solver.CnfWriter(pSat);
+            SatBackend *pSat = EncodeHorizon(Solver, Model::Pull, params, arena);
 
-            int status = sat_solver_solve(pSat, nullptr, nullptr, 0, 0, 0, 0);
+            int status = SolveHorizon(Solver, pSat);
 
             if (status == l_True)
             {
                 foundStep = step;
                 visualizeSolution(preprocessor, Solver, pSat, foundStep, verbose);
+                delete pSat;
                 break;
             }
 
-            sat_solver_delete(pSat);
+            delete pSat;
 
             if (step < 5)
                 step += 1;
@@ -255,18 +1363,16 @@ int Sokoban_CommandSolve(Abc_Frame_t *pAbc, int argc, char **argv)
 
             SokobanSolver Solver(preprocessor);
             Solver.setStepLimit(mid);
-            sat_solver *pSat = sat_solver_new();
-            Solver.PullOnlyConstraints();
-            Solver.CnfWriter(pSat);
+            SatBackend *pSat = EncodeHorizon(Solver, Model::Pull, params, arena);
 
-            int status = sat_solver_solve(pSat, nullptr, nullptr, 0, 0, 0, 0);
+            int status = SolveHorizon(Solver, pSat);
 
             if (status == l_True)
                 high = mid; // Narrow down to smaller step range
             else
                 low = mid + 1; // Increase the lower bound
 
-            sat_solver_delete(pSat);
+            delete pSat;
         }*/
 
         auto stop = high_resolution_clock::now();
@@ -276,57 +1382,7 @@ int Sokoban_CommandSolve(Abc_Frame_t *pAbc, int argc, char **argv)
         cout << "BMC search duration: " << duration.count() << " seconds" << endl;
     }
     else if (runType == 4) // regular BMC with pull only constraints
-    {
-        using namespace std::chrono;
-        auto start = high_resolution_clock::now();
-        Preprocessor preprocessor(map, verbose);
-        preprocessor.loadMap();
-        preprocessor.TunnelIdentifying();
-        preprocessor.findDeadlockPos();
-        preprocessor.findPullRegions();
-        int step = 1;
-        while (true)
-        {
-            auto curr_time = high_resolution_clock::now();
-            auto TLE = hours(1);
-            if (duration_cast<seconds>(curr_time - start) >= TLE)
-            {
-                cout << "Timeout: 1 hour" << endl;
-                WriteResultsToTable(map, true);
-                return 0;
-            }
-            SokobanSolver Solver(preprocessor);
-            Solver.setStepLimit(step);
-            Solver.verbose = verbose;
-            sat_solver *pSat = sat_solver_new();
-            Solver.PullOnlyConstraints();
-            Solver.CnfWriter(pSat);
-
-            int status = sat_solver_solve(pSat, nullptr, nullptr, 0, 0, 0, 0);
-            if (status == l_True)
-            {
-                vector<int> true_literals;
-                auto stop = high_resolution_clock::now();
-                auto duration = duration_cast<microseconds>(stop - start);
-                cout << "Solution found at: " << step << " steps" << endl;
-                double duration_seconds = duration.count() / 1e6; // Convert microseconds to seconds
-
-                // Round to three decimal places
-                duration_seconds = round(duration_seconds * 1000) / 1000.0;
-                cout << "BMC search duration: " << duration_seconds << " seconds" << endl;
-                WriteResultsToTable(map, false, duration_seconds, step);
-
-                if (!verbose)
-                {
-                    return 0;
-                }
-                visualizeSolution(preprocessor, Solver, pSat, step, verbose);
-                return 0;
-            }
-            sat_solver_delete(pSat);
-            step++;
-        }
-    }
+        return Sokoban_RunBmc(map, Model::Pull, params, verbose);
     else if (runType == 5) // regular BMC with pull only constraints
     {
         using namespace std::chrono;
@@ -335,6 +1391,7 @@ int Sokoban_CommandSolve(Abc_Frame_t *pAbc, int argc, char **argv)
         preprocessor.loadMap();
         preprocessor.TunnelIdentifying();
         preprocessor.findDeadlockPos();
+        ClauseArena arena; // only used for -d, refilled for every horizon
         int step = 1;
         int foundStep = -1;
 
@@ -342,11 +1399,9 @@ int Sokoban_CommandSolve(Abc_Frame_t *pAbc, int argc, char **argv)
         {
             SokobanSolver Solver(preprocessor);
             Solver.setStepLimit(step);
-            sat_solver *pSat = sat_solver_new();
-            Solver.PullOnlyConstraints();
-            Solver.CnfWriter(pSat);
+            SatBackend *pSat = EncodeHorizon(Solver, Model::Pull, params, arena);
 
-            int status = sat_solver_solve(pSat, nullptr, nullptr, 0, 0, 0, 0);
+            int status = SolveHorizon(Solver, pSat);
 
             if (status == l_True)
             {
@@ -356,10 +1411,11 @@ int Sokoban_CommandSolve(Abc_Frame_t *pAbc, int argc, char **argv)
                 cout << "Solution found at: " << foundStep << " steps" << endl;
                 cout << "BMC search duration: " << duration.count() << " seconds" << endl;
                 visualizeSolution(preprocessor, Solver, pSat, foundStep, verbose);
+                delete pSat;
                 break;
             }
 
-            sat_solver_delete(pSat);
+            delete pSat;
 
             if (step < 20)
                 step += 8; // Increment by 10 initially
@@ -367,21 +1423,157 @@ int Sokoban_CommandSolve(Abc_Frame_t *pAbc, int argc, char **argv)
                 step += 4; //  Increment by 8 after reaching step 30
         }
     }
+    else if (runType == 6) // regular BMC with the operator encoding
+        return Sokoban_RunBmc(map, Model::Action, params, verbose);
+    else if (runType == 7) // regular BMC with the box-identity-free encoding
+        return Sokoban_RunBmc(map, Model::Occupancy, params, verbose);
+    else if (runType == 8) // BMC over pushes, the player walks between pushes
+        return Sokoban_RunBmc(map, Model::Macro, params, verbose);
+    else if (runType == 9) // BMC that extends one solver frame by frame
+        return Sokoban_RunIncrementalBmc(map, params, verbose);
+    else if (runType == 10) // binary search with assumptions on one instance
+        return Sokoban_RunLatchedSearch(map, params, verbose);
+    else if (runType == 11) // horizons solved concurrently by a pool of threads
+        return Sokoban_RunParallelBmc(map, Model::Push, params, verbose);
+    else if (runType == 12) // open horizons time-sliced by conflict budgets
+        return Sokoban_RunInterleavedBmc(map, params, verbose);
+    else if (runType == 13) // SAT backends racing on every horizon
+        return Sokoban_RunPortfolioBmc(map, params, verbose);
+    else if (runType == 14) // every horizon split into cubes solved in parallel
+        return Sokoban_RunCubeBmc(map, params, verbose);
+    else if (runType == 15) // BMC and PDR / interpolation in parallel
+        return Sokoban_RunProvedBmc(map, params, verbose);
+    else if (runType == 16) // BMC with k-induction
+        return Sokoban_RunInduction(map, params, verbose);
+    else if (runType == 17) // BMC over the AIG-derived CNF
+        return Sokoban_RunAigCnfBmc(map, params, verbose);
+    return 0;
 }
 
-void visualizeSolution(Preprocessor &preprocessor, SokobanSolver &Solver, sat_solver *pSat, int step, bool verbose)
+static int Sokoban_AigUsage(const char *command)
+{
+    cerr << "Usage: " << command << " [-E <engine>] [-T <sec>] [-P <num>] [-n] <map file path>" << endl;
+    cerr << "\t         builds the level as a sequential AIG, makes it the current network and the" << endl;
+    cerr << "\t         current &-space AIG (for write_aiger / &w), and model checks it" << endl;
+    cerr << "\t-E <engine> : bmc3, bmcs (&bmcs, satoko) or bmcg (&bmcs -g, glucose) [default = bmcs]" << endl;
+    cerr << "\t-T <sec>    : timeout of the engine in seconds [default = 3600]" << endl;
+    cerr << "\t-P <num>    : number of parallel solvers of bmcs and bmcg, at most 4 [default = 1]" << endl;
+    cerr << "\t-n          : toggle only building the AIG [default = no]" << endl;
+    return 1;
+}
+// Solves the level with a BMC engine of ABC on its sequential AIG (SokobanAig)
+// and replays the counter-example as a move sequence.
+int Sokoban_CommandAig(Abc_Frame_t *pAbc, int argc, char **argv)
+{
+    string engine = "bmcs";
+    int nTimeOut = 3600, nProcs = 1, fBuildOnly = 0, c;
+    Extra_UtilGetoptReset();
+    while ((c = Extra_UtilGetopt(argc, argv, "ETPnh")) != EOF)
+    {
+        switch (c)
+        {
+        case 'E':
+            if (globalUtilOptind >= argc)
+            {
+                cerr << "Command line switch \"-E\" should be followed by an engine name." << endl;
+                return Sokoban_AigUsage(argv[0]);
+            }
+            engine = argv[globalUtilOptind++];
+            if (engine != "bmc3" && engine != "bmcs" && engine != "bmcg")
+            {
+                cerr << "Unknown engine \"" << engine << "\"." << endl;
+                return Sokoban_AigUsage(argv[0]);
+            }
+            break;
+        case 'T':
+            if (globalUtilOptind >= argc)
+            {
+                cerr << "Command line switch \"-T\" should be followed by an integer." << endl;
+                return Sokoban_AigUsage(argv[0]);
+            }
+            nTimeOut = atoi(argv[globalUtilOptind++]);
+            if (nTimeOut < 0)
+                return Sokoban_AigUsage(argv[0]);
+            break;
+        case 'P':
+            if (globalUtilOptind >= argc)
+            {
+                cerr << "Command line switch \"-P\" should be followed by an integer." << endl;
+                return Sokoban_AigUsage(argv[0]);
+            }
+            nProcs = atoi(argv[globalUtilOptind++]);
+            if (nProcs < 1 || nProcs > 4)
+                return Sokoban_AigUsage(argv[0]);
+            break;
+        case 'n':
+            fBuildOnly ^= 1;
+            break;
+        default:
+            return Sokoban_AigUsage(argv[0]);
+        }
+    }
+    if (argc - globalUtilOptind != 1)
+        return Sokoban_AigUsage(argv[0]);
+    const char *map = argv[globalUtilOptind];
+    using namespace std::chrono;
+    auto start = high_resolution_clock::now();
+    Preprocessor preprocessor(map, false);
+    preprocessor.loadMap();
+    preprocessor.TunnelIdentifying();
+    preprocessor.findDeadlockPos();
+    if (preprocessor.get_playerNum() != 1)
+    {
+        cerr << "The AIG model supports exactly one player." << endl;
+        return 1;
+    }
+    SokobanAig model(preprocessor);
+    Gia_Man_t *pGia = model.Build();
+    cout << "AIG: " << Gia_ManPiNum(pGia) << " inputs, " << Gia_ManRegNum(pGia) << " registers, " << Gia_ManAndNum(pGia) << " AND nodes" << endl;
+    Abc_FrameUpdateGia(pAbc, pGia);
+    if (Cmd_CommandExecute(pAbc, "&put"))
+        return 1;
+    if (fBuildOnly)
+        return 0;
+    string command = engine == "bmc3" ? "bmc3 -T " + to_string(nTimeOut)
+                                      : "&bmcs " + string(engine == "bmcg" ? "-g " : "") + "-P " + to_string(nProcs) + " -T " + to_string(nTimeOut);
+    if (Cmd_CommandExecute(pAbc, command.c_str()))
+        return 1;
+    Abc_Cex_t *pCex = (Abc_Cex_t *)Abc_FrameReadCex(pAbc);
+    if (pCex == nullptr)
+    {
+        cout << "No solution found by " << engine << endl;
+        WriteResultsToTable(map, true);
+        return 0;
+    }
+    bool solved;
+    string moves = model.CexToMoves(pCex, solved);
+    if (!solved)
+    {
+        cerr << "The counter-example of " << engine << " does not solve the level." << endl;
+        return 1;
+    }
+    double duration_seconds = duration_cast<microseconds>(high_resolution_clock::now() - start).count() / 1e6;
+    duration_seconds = round(duration_seconds * 1000) / 1000.0;
+    cout << "Solution found at: " << moves.size() << " steps" << endl;
+    cout << "BMC search duration: " << duration_seconds << " seconds" << endl;
+    cout << "Moves (" << moves.size() << "): " << moves << endl;
+    WriteResultsToTable(map, false, duration_seconds, moves.size());
+    return 0;
+}
+void visualizeSolution(Preprocessor &preprocessor, SokobanSolver &Solver, SatBackend *pSat, int step, bool verbose, int firstFrame)
 {
     if (!verbose)
         return;
 
     // Get true literals from SAT solver
     vector<int> true_literals;
-    const auto &litDict = Solver.get_LitDictionary();
-    for (const auto &[index, lit] : litDict)
+    const VarLayout &layout = Solver.get_layout();
+    int cell, entity, time;
+    for (int var = 1; var < layout.numVars(); var++)
     {
-        if (sat_solver_var_value(pSat, lit.x) > 0)
+        if (layout.Decode(var, cell, entity, time) && pSat->VarValue(var))
         {
-            true_literals.push_back(lit.x);
+            true_literals.push_back(var);
         }
     }
 
@@ -396,7 +1588,7 @@ void visualizeSolution(Preprocessor &preprocessor, SokobanSolver &Solver, sat_so
     } colors;
 
     cout << "Steps in action: " << endl;
-    for (int t = 0; t <= step; t++)
+    for (int t = firstFrame; t <= firstFrame + step; t++)
     {
         // Initialize visualization grid
         auto visual = vector<vector<char>>(preprocessor.get_mapSize().first,
@@ -411,10 +1603,11 @@ void visualizeSolution(Preprocessor &preprocessor, SokobanSolver &Solver, sat_so
         // Place dynamic elements (players and boxes)
         for (int val : true_literals)
         {
-            const auto &lit = Solver.get_LitDictionary(val);
-            if (lit.get_t() == t)
+            layout.Decode(val, cell, entity, time);
+            if (time == t)
             {
-                visual[lit.get_x()][lit.get_y()] = lit.get_identity() == 1 ? 'P' : 'B';
+                const auto &[row, col] = preprocessor.get_board().coord(cell);
+                visual[row][col] = layout.isPlayerEntity(entity) ? 'P' : 'B';
             }
         }
 
@@ -447,7 +1640,7 @@ void visualizeSolution(Preprocessor &preprocessor, SokobanSolver &Solver, sat_so
         }
 
         // Animation delay between steps
-        if (t < step)
+        if (t < firstFrame + step)
         {
             cout.flush();
             this_thread::sleep_for(chrono::seconds(1));